@@ -0,0 +1,58 @@
+#ifndef CHAOSGAME_H
+#define CHAOSGAME_H
+
+#include <cstdint>
+#include <vector>
+
+#include "ChaosKernels.h"
+#include "IFS.h"
+
+// small PCG32 generator, every walker gets its own stream so threads never share state
+class Pcg32
+{
+private:
+    uint64_t state;
+    uint64_t increment;
+
+public:
+    Pcg32(uint64_t seed, uint64_t stream);
+
+    uint32_t next();
+    uint32_t nextBelow(uint32_t bound); // multiply-shift into [0, bound) without a divide
+};
+
+// number of floats constructSierpinshi writes for a run (bounding triangle + every generated point)
+long long sierpinskiFloatCount(long long iterations);
+
+// fills vertices with the bounding triangle followed by iterations chaos game points (x, y, z)
+// the same seed and threadCount always produce the same buffer on every kernel, threadCount of 0 uses every core
+// mortonOrder sorts the points along the Z order curve afterwards so consecutive points land near each other
+void constructSierpinshi(long long iterations, float vertices[], unsigned int threadCount, uint64_t seed,
+                         ChaosKernel kernel = detectChaosKernel(), bool mortonOrder = false);
+
+// deep zoom version of constructSierpinshi, writes iterations points (x, y, z) already in screen coordinates
+// for a view of the given center and zoom (the screen is 2 / zoom gasket units across). every visible level k
+// subtriangle, k about log2(zoom), is the whole gasket under a fixed prefix of vertex choices, so plain chaos game
+// points get mapped through each prefix and nothing is spent outside the screen. density stays the same at any zoom
+void constructSierpinskiView(long long iterations, float vertices[], double centerX, double centerY, double zoom,
+                             unsigned int threadCount, uint64_t seed, ChaosKernel kernel = detectChaosKernel());
+
+// constructSierpinshi without a point count, keeps making points until they stop landing on pixels of a
+// width x height screen that no earlier point has lit, so the count is whatever that resolution actually needs.
+// fills vertices in constructSierpinshi's layout and returns the number of points made
+long long constructSierpinskiConverged(std::vector<float> &vertices, int width, int height, unsigned int threadCount,
+                                       uint64_t seed, ChaosKernel kernel = detectChaosKernel(), bool mortonOrder = false);
+
+// number of floats constructFractal writes, only the gasket keeps its bounding triangle in front
+long long fractalFloatCount(FractalType fractal, long long iterations);
+
+// same as constructSierpinshi for any of the built in fractals, each one runs its own specialized kernels
+void constructFractal(FractalType fractal, long long iterations, float vertices[], unsigned int threadCount, uint64_t seed,
+                      ChaosKernel kernel = detectChaosKernel(), bool mortonOrder = false);
+
+const char *fractalName(FractalType fractal);
+
+// runs one independent group of walkers writing count points into out, this is the work each thread does
+void chaosGameChunk(float out[], long long count, uint64_t seed, uint64_t stream, ChaosKernel kernel);
+
+#endif
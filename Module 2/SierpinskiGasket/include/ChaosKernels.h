@@ -0,0 +1,40 @@
+#ifndef CHAOSKERNELS_H
+#define CHAOSKERNELS_H
+
+#include <cstdint>
+
+// every chunk runs this many walkers side by side, one per AVX-512 lane (AVX2 does them as two halves of 8)
+// keeping the count fixed means every kernel writes the exact same points for a given seed
+const int CHAOS_WALKERS = 16;
+
+// bounding triangle vertices
+extern const float TRIANGLE_X[3];
+extern const float TRIANGLE_Y[3];
+
+// walker state kept as structure of arrays so vector loads line up with the lanes
+struct WalkerState {
+    alignas(64) uint32_t s0[CHAOS_WALKERS]; // xoshiro128+ state, one word of each per walker
+    alignas(64) uint32_t s1[CHAOS_WALKERS];
+    alignas(64) uint32_t s2[CHAOS_WALKERS];
+    alignas(64) uint32_t s3[CHAOS_WALKERS];
+    alignas(64) float x[CHAOS_WALKERS];
+    alignas(64) float y[CHAOS_WALKERS];
+    alignas(64) float z[CHAOS_WALKERS];  // only moves for 3D fractals
+};
+
+enum class ChaosKernel { Scalar, AVX2, AVX512 };
+
+// gasket versions of the templated IFS kernels in IFSKernels.h, for callers that only ever draw the gasket
+// seeds every walker from its own PCG stream and walks it onto the gasket
+void initWalkers(WalkerState &walkers, uint64_t seed, uint64_t stream);
+
+// writes count points (x, y, z) into out, walker i writes points i, i + 16, i + 32, ...
+void runChaosKernel(ChaosKernel kernel, WalkerState &walkers, float out[], long long count);
+
+// best kernel this CPU can run
+ChaosKernel detectChaosKernel();
+bool chaosKernelSupported(ChaosKernel kernel);
+const char *chaosKernelName(ChaosKernel kernel);
+const char *chaosKernelArgument(ChaosKernel kernel); // what --kernel takes to pick it
+
+#endif
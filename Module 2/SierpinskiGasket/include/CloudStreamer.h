@@ -0,0 +1,87 @@
+#ifndef CLOUDSTREAMER_H
+#define CLOUDSTREAMER_H
+
+#include <glad/glad.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "GasketSettings.h"
+#include "PointCloudFile.h"
+
+// keeps a vertex buffer filled with the part of a cloud file the view can see
+// the quadtree culls whole leaf runs and every visible leaf gives the same fraction of its points, picked so the
+// screen gets about POINTS_PER_PIXEL points a pixel, so the upload follows screen size instead of cloud size.
+// there are two buffers: a worker thread fills the back one from the mapped file while the front one keeps getting
+// drawn, and they swap once it's done, so panning never waits on the file paging in
+class CloudStreamer
+{
+private:
+    // run of consecutive leaves that are all on screen
+    struct LeafRun {
+        long long firstLeaf;
+        long long lastLeaf; // one past the end
+    };
+
+    // one of the two vertex buffers and which points are in it
+    struct Slot {
+        unsigned int VBO = 0;
+        unsigned char *mapped = nullptr; // persistently mapped, the worker writes here (GL 4.4 only)
+        std::vector<LeafRun> runs;       // leaves in the order they were written
+        double fraction = -1.0;          // share of each leaf's points it holds
+        long long written = 0;
+    };
+
+    // count points the gather wants at dest in the back buffer, from the front buffer or from the file
+    struct Copy {
+        bool fromFront;
+        long long source;
+        long long dest;
+        long long count;
+    };
+
+    const PointCloudFile &cloud;
+    long long budget;           // most points a buffer holds
+    bool persistent;
+    Slot slots[2];
+    int front;                  // the slot being drawn, the other one is what the worker fills
+    GLsync backFence;           // signalled once the GPU is done drawing what is now the back slot
+    std::unique_ptr<unsigned char[]> staging; // where the worker writes when there's no persistent mapping
+
+    // what the last gather was started for
+    GasketView gatheredView;
+    int gatheredWidth;
+    int gatheredHeight;
+
+    std::thread gatherer;
+    std::atomic<bool> gathered;  // the worker is done and the back slot can be swapped in
+    std::atomic<bool> stopping;
+    std::vector<Copy> copies;    // left for the GL thread by the worker
+
+    void collect(std::vector<LeafRun> &runs, int level, long long node, double x, double y, double minX, double maxX,
+                 double minY, double maxY) const;
+    // worker thread: plans the back slot for this view and copies in everything that has to come from the file
+    void gather(GasketView view, int width, int height);
+    // GL thread: finishes the back slot (copies out of the front, uploads) and starts drawing it
+    void swap();
+    bool backIdle();
+
+public:
+    CloudStreamer(const PointCloudFile &cloud, long long budget);
+    ~CloudStreamer();
+
+    // creates both buffers on the current context
+    void start();
+
+    // swaps in a finished gather and starts the next one if the view or window changed, never waits on the file
+    void update(const GasketView &view, int width, int height);
+
+    // draws the front buffer, the VAO it goes through has to be bound
+    void draw() const;
+
+    void release();
+};
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef COVERAGEBITMAP_H
+#define COVERAGEBITMAP_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// one bit per screen pixel saying whether any point has landed there yet, 190 KB for a 1440x1080 window
+// threads mark it at the same time, a relaxed fetch_or is enough since only the count of new bits matters
+class CoverageBitmap
+{
+private:
+    int width;
+    int height;
+    std::unique_ptr<std::atomic<uint64_t>[]> words;
+
+public:
+    CoverageBitmap(int width, int height);
+
+    // marks the pixel under (x, y) in [-1, 1]^2 screen coordinates, true if nothing had hit it before
+    bool mark(float x, float y){
+        long long column = static_cast<long long>((x * 0.5f + 0.5f) * width);
+        long long row = static_cast<long long>((y * 0.5f + 0.5f) * height);
+        if(x < -1.0f || y < -1.0f || column >= width || row >= height){
+            return false;
+        }
+        long long pixel = row * width + column;
+        uint64_t bit = uint64_t(1) << (pixel & 63);
+        return (words[pixel >> 6].fetch_or(bit, std::memory_order_relaxed) & bit) == 0;
+    }
+
+    long long coveredPixels() const;
+};
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef DENSITYRENDERER_H
+#define DENSITYRENDERER_H
+
+#include <cstdint>
+
+#include "PointFormat.h"
+
+// counts how many points land in each pixel with a compute pass and draws the counts log tone mapped,
+// so the cost follows point count and screen size instead of how much the points overdraw (needs GL 4.3)
+class DensityRenderer
+{
+private:
+    int width;
+    int height;
+
+    unsigned int densityTexture; // r32ui counter per pixel
+    unsigned int peakBuffer;     // highest count so far, the tone map scales against it
+    unsigned int accumulateProgram;
+    unsigned int toneMapProgram;
+    unsigned int emptyVAO;
+
+    void dispatch(long long first, long long count);
+
+public:
+    DensityRenderer(int width, int height);
+
+    static bool supported();
+
+    // bins points [first, first + count) of a tightly packed buffer in the given format
+    void accumulate(unsigned int pointBuffer, PointFormat format, long long first, long long count);
+
+    // bins count points made on the GPU the same way --mode gpu makes them
+    void accumulateGenerated(long long count, uint32_t seed, int depth);
+
+    // tone maps the counts over the whole current framebuffer
+    void draw();
+
+    void release();
+};
+
+#endif
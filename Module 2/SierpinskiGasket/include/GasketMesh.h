@@ -0,0 +1,28 @@
+#ifndef GASKETMESH_H
+#define GASKETMESH_H
+
+#include <cstdint>
+#include <vector>
+
+// the exact level N gasket as 3^N triangles over shared vertices
+// the sub gaskets only ever touch at edge midpoints, so every vertex past the first three is the midpoint
+// one triangle created, numbered in preorder so any subtree knows its own vertex and triangle ranges
+struct GasketMesh {
+    int level = 0;
+    std::vector<float> vertices;        // (x, y, z)
+    std::vector<uint16_t> shortIndices; // used while every vertex fits in 16 bits (level 9 and under)
+    std::vector<uint32_t> indices;      // used past that
+
+    int indexSize() const;              // bytes per index, 2 or 4
+    long long indexCount() const;
+    const void *indexData() const;
+};
+
+long long gasketMeshVertexCount(int level);
+long long gasketMeshTriangleCount(int level);
+
+// builds the mesh with subtrees split across threads, threadCount of 0 uses every core
+// the output is the same for any threadCount
+GasketMesh buildGasketMesh(int level, unsigned int threadCount);
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef GASKETSETTINGS_H
+#define GASKETSETTINGS_H
+
+#include <cstdint>
+#include <string>
+
+#include "ChaosKernels.h"
+#include "IFS.h"
+#include "PointFormat.h"
+#include "PosterRenderer.h"
+
+// how the gasket gets onto the screen
+enum class RenderMode {
+    Points,     // chaos game on the CPU, uploaded as a vertex buffer
+    GpuPoints,  // vertex shader derives every point from gl_VertexID, nothing uploaded
+    Mesh,       // exact level N gasket as an indexed triangle mesh
+    Instanced,  // one triangle drawn 3^N times, placed by the digits of gl_InstanceID
+    Analytic,   // full screen pass testing every pixel for membership, pans and zooms past 10^7x
+    ViewPoints, // chaos game points made only inside the view, regenerated as the camera pans and zooms
+    Raymarch    // 3D tetrahedron ray marched against a folding distance estimate, level is the fold depth
+};
+
+// where the camera looks, center is in the same units as the bounding triangle and zoom 1 shows all of it
+struct GasketView {
+    double centerX = 0.0;
+    double centerY = 0.0;
+    double zoom = 1.0;
+};
+
+// everything the gasket viewer can be told from the command line
+struct GasketSettings {
+    long long iterations = 10000;   // --points
+    bool converge = false;          // --points auto, make points until the window's pixels stop filling in
+    unsigned int threads = 0;       // --threads, 0 means every core
+    uint64_t seed = 0;              // --seed, defaults to the current time
+    RenderMode mode = RenderMode::Points; // --mode points|gpu|mesh|instanced|analytic|view|raymarch
+    int level = 8;                  // --level, subdivision depth for the exact gasket modes
+    GasketView view;                // --center x y, --zoom
+    bool stream = false;            // --stream, draw points while they are still being generated
+    bool density = false;           // --density, log tone mapped hit counts instead of overdrawn points
+    ChaosKernel kernel = ChaosKernel::Scalar; // --kernel scalar|avx2|avx512, defaults to the best one the CPU has
+    FractalType fractal = FractalType::Sierpinski; // --fractal sierpinski|pentagon|hexagon|carpet|fern|tetrahedron
+    PointFormat format = PointFormat::Float3; // --format xyz|xy|half|short, how big each point is in the vertex buffer
+    bool morton = false;            // --morton, sort the points along the Z order curve before uploading
+    bool benchmark = false;         // --benchmark, time drawing the points in generated and Z order, then quit
+    std::string cloudPath;          // --cloud file, draw a precomputed cloud file (written first if it isn't there)
+    int cloudDepth = 8;             // --cloud-depth, quadtree levels of a newly written cloud file
+    std::string posterPath;         // --poster file.png, bin the points on the CPU into an image and quit, no window
+    int posterWidth = 16384;        // --poster-size width height
+    int posterHeight = 16384;
+    unsigned int posterWorkers = 0; // --poster-workers, render the poster as tiles in this many processes, 0 keeps it in this one
+    std::string posterTilePath;     // --poster-tile file x y width height, run as a tile worker for --poster-workers
+    PosterTile posterTile;
+};
+
+GasketSettings parseSettings(int argc, char *argv[]);
+
+#endif
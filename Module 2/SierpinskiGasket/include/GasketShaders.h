@@ -0,0 +1,22 @@
+#ifndef GASKETSHADERS_H
+#define GASKETSHADERS_H
+
+// GLSL for every gasket render mode
+extern const char *vertexShaderSource;
+extern const char *fragmentShaderSource;
+extern const char *compactPointVertexSource;
+extern const char *cloudVertexSource;
+extern const char *gpuPointVertexSource;
+extern const char *instancedVertexSource;
+extern const char *densityComputeSource;
+extern const char *fullscreenVertexSource;
+extern const char *toneMapFragmentSource;
+extern const char *analyticFragmentSource;
+extern const char *raymarchTraceSource;
+extern const char *raymarchResolveSource;
+
+// compiles and links a vertex + fragment program, errors get printed like everywhere else
+unsigned int compileProgram(const char *vertexSource, const char *fragmentSource);
+unsigned int compileComputeProgram(const char *computeSource);
+
+#endif
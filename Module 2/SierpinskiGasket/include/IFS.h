@@ -0,0 +1,201 @@
+#ifndef IFS_H
+#define IFS_H
+
+#include <array>
+#include <cstdint>
+
+// one map of an iterated function system, p' = m * p + t, chosen with probability weight / total weight
+struct AffineMap {
+    float m[3][3];
+    float t[3];
+    float weight;
+};
+
+// map that shrinks everything by scale toward the fixed point (x, y, z), the chaos game step for polygons
+constexpr AffineMap shrinkToward(float scale, float x, float y, float z, float weight = 1.0f){
+    return AffineMap{ { { scale, 0.0f, 0.0f }, { 0.0f, scale, 0.0f }, { 0.0f, 0.0f, scale } },
+                      { x * (1.0f - scale), y * (1.0f - scale), z * (1.0f - scale) }, weight };
+}
+
+// 2D map in the usual a b c d e f notation, x' = a x + b y + e and y' = c x + d y + f
+constexpr AffineMap planarMap(float a, float b, float c, float d, float e, float f, float weight){
+    return AffineMap{ { { a, b, 0.0f }, { c, d, 0.0f }, { 0.0f, 0.0f, 0.0f } }, { e, f, 0.0f }, weight };
+}
+
+// same map after moving the attractor to scale * p + (x, y), used to fit a fractal into the unit square
+constexpr AffineMap fitMap(AffineMap map, float scale, float x, float y){
+    AffineMap fitted = map;
+    fitted.t[0] = (scale * map.t[0]) + x - ((map.m[0][0] * x) + (map.m[0][1] * y));
+    fitted.t[1] = (scale * map.t[1]) + y - ((map.m[1][0] * x) + (map.m[1][1] * y));
+    return fitted;
+}
+
+// std::cos isn't constexpr, a taylor series is plenty for building vertex tables
+constexpr double constexprCos(double angle){
+    const double PI = 3.14159265358979323846;
+    while(angle > PI){
+        angle -= 2.0 * PI;
+    }
+    while(angle < -PI){
+        angle += 2.0 * PI;
+    }
+    double term = 1.0;
+    double sum = 1.0;
+    for(int n = 1; n < 30; n++){
+        term *= -(angle * angle) / ((2.0 * n - 1.0) * (2.0 * n));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double constexprSin(double angle){
+    return constexprCos(angle - 1.57079632679489661923);
+}
+
+// each fractal is a type with its maps as constexpr data so the kernels get instantiated with them baked in
+struct SierpinskiTriangle {
+    static constexpr bool IS_3D = false;
+    static constexpr std::array<AffineMap, 3> MAPS = {
+        shrinkToward(0.5f, -0.5f, -0.5f, 0.0f),
+        shrinkToward(0.5f,  0.0f,  0.5f, 0.0f),
+        shrinkToward(0.5f,  0.5f, -0.5f, 0.0f)
+    };
+};
+
+// chaos game on a regular n-gon, the ratio is the one where the copies touch without overlapping
+template <int N>
+struct PolygonFlake {
+    static constexpr double ratio(){
+        double sum = 1.0;
+        for(int k = 1; k <= N / 4; k++){
+            sum += constexprCos(2.0 * 3.14159265358979323846 * k / N);
+        }
+        return 1.0 / (2.0 * sum);
+    }
+
+    static constexpr std::array<AffineMap, N> buildMaps(){
+        std::array<AffineMap, N> maps{};
+        for(int k = 0; k < N; k++){
+            // first vertex straight up like the triangle
+            double angle = (3.14159265358979323846 * 0.5) + (2.0 * 3.14159265358979323846 * k / N);
+            maps[k] = shrinkToward(static_cast<float>(ratio()), static_cast<float>(0.5 * constexprCos(angle)),
+                                   static_cast<float>(0.5 * constexprSin(angle)), 0.0f);
+        }
+        return maps;
+    }
+
+    static constexpr bool IS_3D = false;
+    static constexpr std::array<AffineMap, N> MAPS = buildMaps();
+};
+
+struct SierpinskiCarpet {
+    static constexpr float THIRD = 1.0f / 3.0f;
+    static constexpr bool IS_3D = false;
+    static constexpr std::array<AffineMap, 8> MAPS = {
+        shrinkToward(THIRD, -0.5f, -0.5f, 0.0f), shrinkToward(THIRD, 0.0f, -0.5f, 0.0f), shrinkToward(THIRD, 0.5f, -0.5f, 0.0f),
+        shrinkToward(THIRD, -0.5f,  0.0f, 0.0f),                                           shrinkToward(THIRD, 0.5f,  0.0f, 0.0f),
+        shrinkToward(THIRD, -0.5f,  0.5f, 0.0f), shrinkToward(THIRD, 0.0f,  0.5f, 0.0f), shrinkToward(THIRD, 0.5f,  0.5f, 0.0f)
+    };
+};
+
+// Barnsley's fern is about 5 wide and 10 tall, shrunk by 10 and moved down so it fills the window
+struct BarnsleyFern {
+    static constexpr bool IS_3D = false;
+    static constexpr std::array<AffineMap, 4> MAPS = {
+        fitMap(planarMap( 0.00f,  0.00f,  0.00f, 0.16f, 0.0f, 0.00f, 0.01f), 0.1f, 0.0f, -0.5f), // stem
+        fitMap(planarMap( 0.85f,  0.04f, -0.04f, 0.85f, 0.0f, 1.60f, 0.85f), 0.1f, 0.0f, -0.5f), // smaller copy of the whole fern
+        fitMap(planarMap( 0.20f, -0.26f,  0.23f, 0.22f, 0.0f, 1.60f, 0.07f), 0.1f, 0.0f, -0.5f), // left leaflet
+        fitMap(planarMap(-0.15f,  0.28f,  0.26f, 0.24f, 0.0f, 0.44f, 0.07f), 0.1f, 0.0f, -0.5f)  // right leaflet
+    };
+};
+
+// tetrahedron on alternate corners of the unit cube, looking down z shows a square of gaskets
+struct SierpinskiTetrahedron {
+    static constexpr bool IS_3D = true;
+    static constexpr std::array<AffineMap, 4> MAPS = {
+        shrinkToward(0.5f,  0.5f,  0.5f,  0.5f),
+        shrinkToward(0.5f,  0.5f, -0.5f, -0.5f),
+        shrinkToward(0.5f, -0.5f,  0.5f, -0.5f),
+        shrinkToward(0.5f, -0.5f, -0.5f,  0.5f)
+    };
+};
+
+// everything the kernels need worked out from the maps at compile time
+template <typename Fractal>
+struct IFSTraits {
+    static constexpr int MAP_COUNT = static_cast<int>(Fractal::MAPS.size());
+
+    static constexpr bool uniformWeights(){
+        for(const AffineMap &map : Fractal::MAPS){
+            if(map.weight != Fractal::MAPS[0].weight){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // every map is the same uniform scale, so a step is just (p + offset) * scale like the original gasket
+    static constexpr bool uniformScale(){
+        float scale = Fractal::MAPS[0].m[0][0];
+        for(const AffineMap &map : Fractal::MAPS){
+            for(int row = 0; row < 3; row++){
+                for(int column = 0; column < 3; column++){
+                    float expected = (row == column) ? scale : 0.0f;
+                    if(map.m[row][column] != expected){
+                        return false;
+                    }
+                }
+            }
+        }
+        return scale != 0.0f;
+    }
+
+    // the top 16 random bits pick the map, map k wins when they land at or past THRESHOLDS[k - 1]
+    static constexpr std::array<uint32_t, MAP_COUNT> thresholds(){
+        float total = 0.0f;
+        for(const AffineMap &map : Fractal::MAPS){
+            total += map.weight;
+        }
+        std::array<uint32_t, MAP_COUNT> result{};
+        float running = 0.0f;
+        for(int k = 0; k < MAP_COUNT; k++){
+            running += Fractal::MAPS[k].weight;
+            result[k] = static_cast<uint32_t>((running / total) * 65536.0f);
+        }
+        return result;
+    }
+
+    // steps until the starting point's error is below float precision, worst map decides
+    // never fewer than the 32 the gasket always used so its points don't change
+    static constexpr int burnInSteps(){
+        float worst = 0.0f;
+        for(const AffineMap &map : Fractal::MAPS){
+            for(int row = 0; row < 3; row++){
+                float rowSum = 0.0f;
+                for(int column = 0; column < 3; column++){
+                    rowSum += (map.m[row][column] < 0.0f) ? -map.m[row][column] : map.m[row][column];
+                }
+                worst = (rowSum > worst) ? rowSum : worst;
+            }
+        }
+        int steps = 0;
+        for(float error = 1.0f; error > 1.0f / 16777216.0f && steps < 256; error *= worst){
+            steps++;
+        }
+        return (steps < 32) ? 32 : steps;
+    }
+
+    static constexpr bool UNIFORM_WEIGHTS = uniformWeights();
+    static constexpr bool UNIFORM_SCALE = uniformScale();
+    static constexpr float SCALE = Fractal::MAPS[0].m[0][0];
+    static constexpr std::array<uint32_t, MAP_COUNT> THRESHOLDS = thresholds();
+    static constexpr int BURN_IN_STEPS = burnInSteps();
+
+    // the kernels look maps up with a register permute, AVX2 has 8 slots
+    static_assert(MAP_COUNT >= 1 && MAP_COUNT <= 8, "chaos game kernels handle 1 to 8 maps");
+};
+
+// fractals the viewer can draw with --fractal
+enum class FractalType { Sierpinski, Pentagon, Hexagon, Carpet, Fern, Tetrahedron };
+
+#endif
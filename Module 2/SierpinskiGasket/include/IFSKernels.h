@@ -0,0 +1,458 @@
+#ifndef IFSKERNELS_H
+#define IFSKERNELS_H
+
+#include <algorithm>
+#include <array>
+#include <thread>
+#include <vector>
+
+#include "ChaosGame.h"
+#include "IFS.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define CHAOS_X86 1
+#include <immintrin.h>
+#else
+#define CHAOS_X86 0
+#endif
+
+// chunks smaller than this are not worth starting a thread for
+const long long MIN_POINTS_PER_THREAD = 1 << 16;
+
+// floats written by one step of all the walkers
+const int FLOATS_PER_STEP = CHAOS_WALKERS * 3;
+
+// per map coefficients laid out as 16 wide lookup tables, one register each in the vector kernels
+// uniform scale fractals only use OFFSET (t / scale), everything else uses M and T
+template <typename Fractal>
+struct IFSTables {
+    using Table = std::array<float, CHAOS_WALKERS>;
+
+    static constexpr std::array<Table, 3> offsets(){
+        std::array<Table, 3> result{};
+        if(!IFSTraits<Fractal>::UNIFORM_SCALE){
+            return result;
+        }
+        for(int k = 0; k < IFSTraits<Fractal>::MAP_COUNT; k++){
+            for(int axis = 0; axis < 3; axis++){
+                result[axis][k] = Fractal::MAPS[k].t[axis] / IFSTraits<Fractal>::SCALE;
+            }
+        }
+        return result;
+    }
+
+    static constexpr std::array<Table, 9> matrix(){
+        std::array<Table, 9> result{};
+        for(int k = 0; k < IFSTraits<Fractal>::MAP_COUNT; k++){
+            for(int entry = 0; entry < 9; entry++){
+                result[entry][k] = Fractal::MAPS[k].m[entry / 3][entry % 3];
+            }
+        }
+        return result;
+    }
+
+    static constexpr std::array<Table, 3> translation(){
+        std::array<Table, 3> result{};
+        for(int k = 0; k < IFSTraits<Fractal>::MAP_COUNT; k++){
+            for(int axis = 0; axis < 3; axis++){
+                result[axis][k] = Fractal::MAPS[k].t[axis];
+            }
+        }
+        return result;
+    }
+
+    static constexpr std::array<Table, 3> OFFSET = offsets();
+    static constexpr std::array<Table, 9> M = matrix();
+    static constexpr std::array<Table, 3> T = translation();
+};
+
+// one step of a single walker, every kernel has to match this bit for bit
+template <typename Fractal>
+inline void stepWalker(WalkerState &w, int lane){
+    using Traits = IFSTraits<Fractal>;
+    using Tables = IFSTables<Fractal>;
+
+    uint32_t random = w.s0[lane] + w.s3[lane];
+
+    // xoshiro128+ state update
+    uint32_t t = w.s1[lane] << 9;
+    w.s2[lane] ^= w.s0[lane];
+    w.s3[lane] ^= w.s1[lane];
+    w.s1[lane] ^= w.s2[lane];
+    w.s0[lane] ^= w.s3[lane];
+    w.s2[lane] ^= t;
+    w.s3[lane] = (w.s3[lane] << 11) | (w.s3[lane] >> 21);
+
+    // top 16 bits pick the map, no branch and no modulo
+    uint32_t map = 0;
+    if constexpr (Traits::UNIFORM_WEIGHTS){
+        map = ((random >> 16) * Traits::MAP_COUNT) >> 16;
+    } else{
+        for(int k = 0; k + 1 < Traits::MAP_COUNT; k++){
+            map += ((random >> 16) >= Traits::THRESHOLDS[k]) ? 1u : 0u;
+        }
+    }
+
+    if constexpr (Traits::UNIFORM_SCALE){
+        w.x[lane] = (w.x[lane] + Tables::OFFSET[0][map]) * Traits::SCALE;
+        w.y[lane] = (w.y[lane] + Tables::OFFSET[1][map]) * Traits::SCALE;
+        if constexpr (Fractal::IS_3D){
+            w.z[lane] = (w.z[lane] + Tables::OFFSET[2][map]) * Traits::SCALE;
+        }
+    } else{
+        float x = w.x[lane];
+        float y = w.y[lane];
+        float z = w.z[lane];
+        if constexpr (Fractal::IS_3D){
+            w.x[lane] = (((Tables::M[0][map] * x) + (Tables::M[1][map] * y)) + (Tables::M[2][map] * z)) + Tables::T[0][map];
+            w.y[lane] = (((Tables::M[3][map] * x) + (Tables::M[4][map] * y)) + (Tables::M[5][map] * z)) + Tables::T[1][map];
+            w.z[lane] = (((Tables::M[6][map] * x) + (Tables::M[7][map] * y)) + (Tables::M[8][map] * z)) + Tables::T[2][map];
+        } else{
+            w.x[lane] = ((Tables::M[0][map] * x) + (Tables::M[1][map] * y)) + Tables::T[0][map];
+            w.y[lane] = ((Tables::M[3][map] * x) + (Tables::M[4][map] * y)) + Tables::T[1][map];
+        }
+    }
+}
+
+// seeds every walker from its own PCG stream and walks it onto the attractor
+template <typename Fractal>
+void initIFSWalkers(WalkerState &walkers, uint64_t seed, uint64_t stream){
+    Pcg32 rng(seed, stream);
+    for(int lane = 0; lane < CHAOS_WALKERS; lane++){
+        walkers.s0[lane] = rng.next();
+        walkers.s1[lane] = rng.next();
+        walkers.s2[lane] = rng.next();
+        walkers.s3[lane] = rng.next();
+        if((walkers.s0[lane] | walkers.s1[lane] | walkers.s2[lane] | walkers.s3[lane]) == 0){
+            walkers.s0[lane] = 1; // all zero state would never leave zero
+        }
+
+        // picking an actual random initial point is hard so intial point is 0,0 and we walk it onto the attractor
+        walkers.x[lane] = 0.0f;
+        walkers.y[lane] = 0.0f;
+        walkers.z[lane] = 0.0f;
+        for(int i = 0; i < IFSTraits<Fractal>::BURN_IN_STEPS; i++){
+            stepWalker<Fractal>(walkers, lane);
+        }
+    }
+}
+
+template <typename Fractal>
+void chaosScalar(WalkerState &w, float out[], long long steps){
+    for(long long step = 0; step < steps; step++){
+        float *stepOut = out + step * FLOATS_PER_STEP;
+        for(int lane = 0; lane < CHAOS_WALKERS; lane++){
+            stepWalker<Fractal>(w, lane);
+            stepOut[(lane * 3)] = w.x[lane];
+            stepOut[(lane * 3) + 1] = w.y[lane];
+            stepOut[(lane * 3) + 2] = w.z[lane]; // stays zero for 2D fractals
+        }
+    }
+}
+
+#if CHAOS_X86
+__attribute__((target("avx2")))
+inline __m256i rotateLeftAVX2(__m256i value, int bits){
+    return _mm256_or_si256(_mm256_slli_epi32(value, bits), _mm256_srli_epi32(value, 32 - bits));
+}
+
+template <typename Fractal>
+__attribute__((target("avx2")))
+void chaosAVX2(WalkerState &w, float out[], long long steps){
+    using Traits = IFSTraits<Fractal>;
+    using Tables = IFSTables<Fractal>;
+
+    // lookup tables, only the ones this fractal needs end up in registers
+    __m256 offset[3], matrix[9], translation[3];
+    for(int i = 0; i < 3; i++){
+        offset[i] = _mm256_loadu_ps(Tables::OFFSET[i].data());
+        translation[i] = _mm256_loadu_ps(Tables::T[i].data());
+    }
+    for(int i = 0; i < 9; i++){
+        matrix[i] = _mm256_loadu_ps(Tables::M[i].data());
+    }
+    const __m256 scale = _mm256_set1_ps(Traits::SCALE);
+    const __m256i mapCount = _mm256_set1_epi32(Traits::MAP_COUNT);
+
+    // turning 8 x's, y's and z's into 24 interleaved floats: float j of store k belongs to
+    // walker (8k + j) / 3, component (8k + j) % 3 picks x, y or z
+    __m256i interleave[3];
+    __m256 takeY[3];
+    __m256 takeZ[3];
+    for(int k = 0; k < 3; k++){
+        alignas(32) int32_t index[8];
+        alignas(32) int32_t yMask[8];
+        alignas(32) int32_t zMask[8];
+        for(int j = 0; j < 8; j++){
+            int position = (8 * k) + j;
+            index[j] = position / 3;
+            yMask[j] = (position % 3 == 1) ? -1 : 0;
+            zMask[j] = (position % 3 == 2) ? -1 : 0;
+        }
+        interleave[k] = _mm256_load_si256(reinterpret_cast<const __m256i*>(index));
+        takeY[k] = _mm256_castsi256_ps(_mm256_load_si256(reinterpret_cast<const __m256i*>(yMask)));
+        takeZ[k] = _mm256_castsi256_ps(_mm256_load_si256(reinterpret_cast<const __m256i*>(zMask)));
+    }
+
+    // both halves of the walkers stay in registers for the whole run
+    __m256i s0[2], s1[2], s2[2], s3[2];
+    __m256 x[2], y[2], z[2];
+    for(int h = 0; h < 2; h++){
+        s0[h] = _mm256_load_si256(reinterpret_cast<const __m256i*>(w.s0 + (h * 8)));
+        s1[h] = _mm256_load_si256(reinterpret_cast<const __m256i*>(w.s1 + (h * 8)));
+        s2[h] = _mm256_load_si256(reinterpret_cast<const __m256i*>(w.s2 + (h * 8)));
+        s3[h] = _mm256_load_si256(reinterpret_cast<const __m256i*>(w.s3 + (h * 8)));
+        x[h] = _mm256_load_ps(w.x + (h * 8));
+        y[h] = _mm256_load_ps(w.y + (h * 8));
+        z[h] = _mm256_load_ps(w.z + (h * 8));
+    }
+
+    for(long long step = 0; step < steps; step++){
+        float *stepOut = out + step * FLOATS_PER_STEP;
+        for(int h = 0; h < 2; h++){
+            __m256i random = _mm256_add_epi32(s0[h], s3[h]);
+
+            __m256i t = _mm256_slli_epi32(s1[h], 9);
+            s2[h] = _mm256_xor_si256(s2[h], s0[h]);
+            s3[h] = _mm256_xor_si256(s3[h], s1[h]);
+            s1[h] = _mm256_xor_si256(s1[h], s2[h]);
+            s0[h] = _mm256_xor_si256(s0[h], s3[h]);
+            s2[h] = _mm256_xor_si256(s2[h], t);
+            s3[h] = rotateLeftAVX2(s3[h], 11);
+
+            __m256i top = _mm256_srli_epi32(random, 16);
+            __m256i map;
+            if constexpr (Traits::UNIFORM_WEIGHTS){
+                map = _mm256_srli_epi32(_mm256_mullo_epi32(top, mapCount), 16);
+            } else{
+                // every threshold passed is a -1 in the compare mask, so subtracting the masks counts them
+                map = _mm256_setzero_si256();
+                for(int k = 0; k + 1 < Traits::MAP_COUNT; k++){
+                    __m256i below = _mm256_set1_epi32(static_cast<int32_t>(Traits::THRESHOLDS[k]) - 1);
+                    map = _mm256_sub_epi32(map, _mm256_cmpgt_epi32(top, below));
+                }
+            }
+
+            if constexpr (Traits::UNIFORM_SCALE){
+                x[h] = _mm256_mul_ps(_mm256_add_ps(x[h], _mm256_permutevar8x32_ps(offset[0], map)), scale);
+                y[h] = _mm256_mul_ps(_mm256_add_ps(y[h], _mm256_permutevar8x32_ps(offset[1], map)), scale);
+                if constexpr (Fractal::IS_3D){
+                    z[h] = _mm256_mul_ps(_mm256_add_ps(z[h], _mm256_permutevar8x32_ps(offset[2], map)), scale);
+                }
+            } else{
+                __m256 row[3];
+                for(int r = 0; r < (Fractal::IS_3D ? 3 : 2); r++){
+                    row[r] = _mm256_add_ps(_mm256_mul_ps(_mm256_permutevar8x32_ps(matrix[(r * 3)], map), x[h]),
+                                           _mm256_mul_ps(_mm256_permutevar8x32_ps(matrix[(r * 3) + 1], map), y[h]));
+                    if constexpr (Fractal::IS_3D){
+                        row[r] = _mm256_add_ps(row[r], _mm256_mul_ps(_mm256_permutevar8x32_ps(matrix[(r * 3) + 2], map), z[h]));
+                    }
+                    row[r] = _mm256_add_ps(row[r], _mm256_permutevar8x32_ps(translation[r], map));
+                }
+                x[h] = row[0];
+                y[h] = row[1];
+                if constexpr (Fractal::IS_3D){
+                    z[h] = row[2];
+                }
+            }
+
+            for(int k = 0; k < 3; k++){
+                __m256 fromX = _mm256_permutevar8x32_ps(x[h], interleave[k]);
+                __m256 fromY = _mm256_permutevar8x32_ps(y[h], interleave[k]);
+                __m256 fromZ = _mm256_permutevar8x32_ps(z[h], interleave[k]);
+                __m256 packed = _mm256_blendv_ps(_mm256_blendv_ps(fromX, fromY, takeY[k]), fromZ, takeZ[k]);
+                _mm256_storeu_ps(stepOut + (h * 24) + (k * 8), packed);
+            }
+        }
+    }
+
+    for(int h = 0; h < 2; h++){
+        _mm256_store_si256(reinterpret_cast<__m256i*>(w.s0 + (h * 8)), s0[h]);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(w.s1 + (h * 8)), s1[h]);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(w.s2 + (h * 8)), s2[h]);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(w.s3 + (h * 8)), s3[h]);
+        _mm256_store_ps(w.x + (h * 8), x[h]);
+        _mm256_store_ps(w.y + (h * 8), y[h]);
+        _mm256_store_ps(w.z + (h * 8), z[h]);
+    }
+}
+
+template <typename Fractal>
+__attribute__((target("avx512f")))
+void chaosAVX512(WalkerState &w, float out[], long long steps){
+    using Traits = IFSTraits<Fractal>;
+    using Tables = IFSTables<Fractal>;
+
+    __m512 offset[3], matrix[9], translation[3];
+    for(int i = 0; i < 3; i++){
+        offset[i] = _mm512_loadu_ps(Tables::OFFSET[i].data());
+        translation[i] = _mm512_loadu_ps(Tables::T[i].data());
+    }
+    for(int i = 0; i < 9; i++){
+        matrix[i] = _mm512_loadu_ps(Tables::M[i].data());
+    }
+    const __m512 scale = _mm512_set1_ps(Traits::SCALE);
+    const __m512i mapCount = _mm512_set1_epi32(Traits::MAP_COUNT);
+    const __m512i one = _mm512_set1_epi32(1);
+
+    // same interleave as AVX2 but over x and y at once, index 16+ reads from y and the z slots get masked
+    __m512i interleave[3];
+    __mmask16 takeZ[3];
+    for(int k = 0; k < 3; k++){
+        alignas(64) int32_t index[16];
+        takeZ[k] = 0;
+        for(int j = 0; j < 16; j++){
+            int position = (16 * k) + j;
+            index[j] = (position / 3) + ((position % 3 == 1) ? 16 : 0);
+            if(position % 3 == 2){
+                takeZ[k] |= static_cast<__mmask16>(1u << j);
+            }
+        }
+        interleave[k] = _mm512_load_si512(index);
+    }
+
+    __m512i s0 = _mm512_load_si512(w.s0);
+    __m512i s1 = _mm512_load_si512(w.s1);
+    __m512i s2 = _mm512_load_si512(w.s2);
+    __m512i s3 = _mm512_load_si512(w.s3);
+    __m512 x = _mm512_load_ps(w.x);
+    __m512 y = _mm512_load_ps(w.y);
+    __m512 z = _mm512_load_ps(w.z);
+
+    for(long long step = 0; step < steps; step++){
+        float *stepOut = out + step * FLOATS_PER_STEP;
+        __m512i random = _mm512_add_epi32(s0, s3);
+
+        __m512i t = _mm512_slli_epi32(s1, 9);
+        s2 = _mm512_xor_si512(s2, s0);
+        s3 = _mm512_xor_si512(s3, s1);
+        s1 = _mm512_xor_si512(s1, s2);
+        s0 = _mm512_xor_si512(s0, s3);
+        s2 = _mm512_xor_si512(s2, t);
+        s3 = _mm512_rol_epi32(s3, 11);
+
+        __m512i top = _mm512_srli_epi32(random, 16);
+        __m512i map;
+        if constexpr (Traits::UNIFORM_WEIGHTS){
+            map = _mm512_srli_epi32(_mm512_mullo_epi32(top, mapCount), 16);
+        } else{
+            map = _mm512_setzero_si512();
+            for(int k = 0; k + 1 < Traits::MAP_COUNT; k++){
+                __mmask16 passed = _mm512_cmpge_epi32_mask(top, _mm512_set1_epi32(static_cast<int32_t>(Traits::THRESHOLDS[k])));
+                map = _mm512_mask_add_epi32(map, passed, map, one);
+            }
+        }
+
+        if constexpr (Traits::UNIFORM_SCALE){
+            x = _mm512_mul_ps(_mm512_add_ps(x, _mm512_permutexvar_ps(map, offset[0])), scale);
+            y = _mm512_mul_ps(_mm512_add_ps(y, _mm512_permutexvar_ps(map, offset[1])), scale);
+            if constexpr (Fractal::IS_3D){
+                z = _mm512_mul_ps(_mm512_add_ps(z, _mm512_permutexvar_ps(map, offset[2])), scale);
+            }
+        } else{
+            __m512 row[3];
+            for(int r = 0; r < (Fractal::IS_3D ? 3 : 2); r++){
+                row[r] = _mm512_add_ps(_mm512_mul_ps(_mm512_permutexvar_ps(map, matrix[(r * 3)]), x),
+                                       _mm512_mul_ps(_mm512_permutexvar_ps(map, matrix[(r * 3) + 1]), y));
+                if constexpr (Fractal::IS_3D){
+                    row[r] = _mm512_add_ps(row[r], _mm512_mul_ps(_mm512_permutexvar_ps(map, matrix[(r * 3) + 2]), z));
+                }
+                row[r] = _mm512_add_ps(row[r], _mm512_permutexvar_ps(map, translation[r]));
+            }
+            x = row[0];
+            y = row[1];
+            if constexpr (Fractal::IS_3D){
+                z = row[2];
+            }
+        }
+
+        for(int k = 0; k < 3; k++){
+            __m512 packed;
+            if constexpr (Fractal::IS_3D){
+                // z slots index their own lane so the same interleave pulls them out of z
+                packed = _mm512_mask_permutexvar_ps(_mm512_permutex2var_ps(x, interleave[k], y), takeZ[k], interleave[k], z);
+            } else{
+                packed = _mm512_maskz_permutex2var_ps(static_cast<__mmask16>(~takeZ[k]), x, interleave[k], y);
+            }
+            _mm512_storeu_ps(stepOut + (k * 16), packed);
+        }
+    }
+
+    _mm512_store_si512(w.s0, s0);
+    _mm512_store_si512(w.s1, s1);
+    _mm512_store_si512(w.s2, s2);
+    _mm512_store_si512(w.s3, s3);
+    _mm512_store_ps(w.x, x);
+    _mm512_store_ps(w.y, y);
+    _mm512_store_ps(w.z, z);
+}
+#endif
+
+// writes count points (x, y, z) into out, walker i writes points i, i + 16, i + 32, ...
+template <typename Fractal>
+void runIFSKernel(ChaosKernel kernel, WalkerState &walkers, float out[], long long count){
+    long long steps = count / CHAOS_WALKERS;
+
+    switch(kernel){
+#if CHAOS_X86
+        case ChaosKernel::AVX512:
+            chaosAVX512<Fractal>(walkers, out, steps);
+        break;
+        case ChaosKernel::AVX2:
+            chaosAVX2<Fractal>(walkers, out, steps);
+        break;
+#endif
+        default:
+            chaosScalar<Fractal>(walkers, out, steps);
+    }
+
+    // leftover points go to the first few walkers so the tail matches a full step
+    float *tail = out + steps * FLOATS_PER_STEP;
+    int remaining = static_cast<int>(count - steps * CHAOS_WALKERS);
+    for(int lane = 0; lane < remaining; lane++){
+        stepWalker<Fractal>(walkers, lane);
+        tail[(lane * 3)] = walkers.x[lane];
+        tail[(lane * 3) + 1] = walkers.y[lane];
+        tail[(lane * 3) + 2] = walkers.z[lane];
+    }
+}
+
+template <typename Fractal>
+void ifsChunk(float out[], long long count, uint64_t seed, uint64_t stream, ChaosKernel kernel){
+    WalkerState walkers;
+    initIFSWalkers<Fractal>(walkers, seed, stream);
+    runIFSKernel<Fractal>(kernel, walkers, out, count);
+}
+
+// fills points with count chaos game points (x, y, z) split into one contiguous chunk per thread
+// the output only depends on seed and threadCount, never on the kernel
+template <typename Fractal>
+void constructIFS(long long count, float points[], unsigned int threadCount, uint64_t seed, ChaosKernel kernel){
+    if(threadCount == 0){
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    long long chunkSize = (count + threadCount - 1) / threadCount;
+    bool runSerial = chunkSize < MIN_POINTS_PER_THREAD;
+
+    std::vector<std::thread> workers;
+    for(unsigned int t = 0; t < threadCount; t++){
+        long long first = std::min(count, t * chunkSize);
+        long long chunk = std::min(count - first, chunkSize);
+        if(chunk <= 0){
+            break;
+        }
+
+        if(runSerial){
+            ifsChunk<Fractal>(points + first * 3, chunk, seed, t, kernel);
+        } else{
+            workers.emplace_back(ifsChunk<Fractal>, points + first * 3, chunk, seed, static_cast<uint64_t>(t), kernel);
+        }
+    }
+
+    for(std::thread &worker : workers){
+        worker.join();
+    }
+}
+
+#endif
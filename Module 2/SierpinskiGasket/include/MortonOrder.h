@@ -0,0 +1,14 @@
+#ifndef MORTONORDER_H
+#define MORTONORDER_H
+
+#include <cstdint>
+
+// Z order key of a point in [-0.5, 0.5]^2, 16 bits per axis with x in the even bits
+// points outside the square get clamped onto its edge
+uint32_t mortonKey(float x, float y);
+
+// reorders count (x, y, z) points along the Z order curve so neighbours in the buffer are neighbours on screen
+// parallel LSD radix sort over the key a byte at a time, stable and the same for any threadCount (0 uses every core)
+void sortPointsMorton(float points[], long long count, unsigned int threadCount);
+
+#endif
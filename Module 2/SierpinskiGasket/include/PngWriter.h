@@ -0,0 +1,34 @@
+#ifndef PNGWRITER_H
+#define PNGWRITER_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+// writes an 8 bit RGB PNG one row at a time, so an image never has to be in memory all at once
+// the rows go in as stored (uncompressed) deflate blocks, no zlib needed and posters are mostly noise anyway
+class PngWriter
+{
+private:
+    std::ofstream file;
+    int width;
+    int height;
+    int rowsWritten;
+    uint32_t adler;          // adler32 of everything inside the zlib stream so far
+    std::string chunkData;   // reused so rows don't allocate
+
+    void writeChunk(const char type[4], const std::string &data);
+
+public:
+    PngWriter();
+
+    bool open(const std::string &path, int width, int height);
+
+    // width RGB triples, top row first
+    void writeRow(const unsigned char rgb[]);
+
+    // finishes the zlib stream and the file, false if anything failed to write
+    bool close();
+};
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef POINTCLOUDFILE_H
+#define POINTCLOUDFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "ChaosKernels.h"
+#include "IFS.h"
+#include "PointFormat.h"
+
+// a precomputed point cloud on disk, laid out as
+//   CloudHeader
+//   leafCount + 1 uint64 point offsets, leaf i holds points [offset[i], offset[i + 1])
+//   pointCount packed points, grouped by leaf
+// leaves are the cells of a quadtree over [-0.5, 0.5]^2 at depth levels, numbered in Z order so every quadtree
+// node is one contiguous run of leaves. inside a leaf the points stay in generation order, which makes any
+// prefix of a leaf an even sample of it and is what the viewer uses for level of detail
+struct CloudHeader {
+    char magic[8];          // "GASKETQT", written last so a build that never finished can't pass for a cloud
+    uint32_t version;
+    uint32_t depth;         // quadtree levels, 4^depth leaves
+    uint64_t pointCount;
+    uint32_t format;        // PointFormat of every point
+    uint32_t fractal;       // FractalType the points are from
+};
+
+const uint32_t CLOUD_VERSION = 2;
+
+// deepest quadtree the builder makes, 4^12 leaves is already a 128 MB index
+const int MAX_CLOUD_DEPTH = 12;
+
+// a whole file mapped into memory, mmap on POSIX and a file mapping on Windows
+class MappedFile
+{
+private:
+    unsigned char *bytes;
+    size_t length;
+#ifdef _WIN32
+    void *fileHandle;
+    void *mappingHandle;
+#else
+    int descriptor;
+#endif
+
+public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool openRead(const std::string &path);
+    bool create(const std::string &path, size_t size); // replaces whatever was there, mapped read write
+
+    void flush(); // waits for everything written through the mapping to reach the disk
+
+    void close();
+
+    unsigned char *data() const;
+    size_t size() const;
+};
+
+// read side of a cloud file, nothing is read from disk until the points get touched
+class PointCloudFile
+{
+private:
+    MappedFile file;
+    const CloudHeader *header;
+    const uint64_t *leafOffsets;
+    const unsigned char *pointData;
+
+public:
+    PointCloudFile();
+
+    // checks the header and index against the file size, errors get printed
+    bool open(const std::string &path);
+    void close();
+    bool isOpen() const;
+
+    int depth() const;
+    FractalType fractal() const;
+    long long pointCount() const;
+    long long leafCount() const;
+    PointFormat format() const;
+
+    long long leafBegin(long long leaf) const;  // first point of leaf, leafBegin(leafCount()) is pointCount()
+    const unsigned char *point(long long index) const;
+};
+
+// true when path has to be built first: it doesn't exist, or a build was interrupted before writing the magic
+bool pointCloudNeedsBuild(const std::string &path);
+
+// generates pointCount chaos game points of fractal and writes them out as a cloud file a block at a time,
+// so the cloud can be far bigger than memory. every block is generated twice, once to size the leaves
+// and once to fill them, which is cheaper than keeping the points around. the header goes in only once
+// every point is on disk
+bool buildPointCloud(const std::string &path, FractalType fractal, long long pointCount, int depth, PointFormat format,
+                     unsigned int threadCount, uint64_t seed, ChaosKernel kernel);
+
+#endif
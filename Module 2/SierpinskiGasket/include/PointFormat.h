@@ -0,0 +1,31 @@
+#ifndef POINTFORMAT_H
+#define POINTFORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+
+// how each point sits in the vertex buffer, every format past Float3 drops z since the points are flat
+enum class PointFormat {
+    Float3, // 12 bytes, (x, y, z) floats like the chaos game writes them
+    Float2, // 8 bytes, (x, y) floats
+    Half2,  // 4 bytes, (x, y) half floats, about 1/4000 of the gasket at its widest
+    Short2  // 4 bytes, (x, y) normalized shorts holding 2x so [-0.5, 0.5] uses the whole range
+};
+
+size_t pointFormatStride(PointFormat format);
+const char *pointFormatName(PointFormat format);
+
+// what the compact vertex shader has to multiply positions by to undo the packing
+float pointFormatScale(PointFormat format);
+
+// round to nearest even float to IEEE half conversion, same as the hardware does it
+uint16_t floatToHalf(float value);
+
+// squeezes count (x, y, z) points into format, out may be the same memory as points since
+// every packed point ends at or before where its source started
+void packPoints(PointFormat format, const float points[], long long count, void *out);
+
+// glVertexAttribPointer for attribute 0 in this format, VAO and VBO have to be bound
+void setPointAttribute(PointFormat format);
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef POINTSTREAM_H
+#define POINTSTREAM_H
+
+#include <glad/glad.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "ChaosKernels.h"
+#include "DensityRenderer.h"
+#include "PointFormat.h"
+
+// streams chaos game points into vertex buffers from a producer thread while the render loop draws
+// whatever has arrived so far, so the first frame shows up right away no matter how many points we want.
+// the points are split over fixed size chunks that only get made as the producer reaches them, so a billion
+// points never asks for one giant buffer up front and every draw stays well inside a GLsizei
+class PointStream
+{
+private:
+    long long iterations;
+    uint64_t seed;
+    ChaosKernel kernel;
+    PointFormat format;
+
+    std::vector<unsigned int> buffers; // one per chunk made so far, only touched on the GL thread
+    // where the producer writes each chunk: mapped by the GL thread, or staging memory the producer makes
+    std::unique_ptr<std::atomic<unsigned char*>[]> chunkData;
+    bool persistent;
+    long long uploaded;             // points already sent with glBufferSubData (staging path only)
+
+    std::thread producer;
+    std::atomic<long long> produced; // points the producer has finished writing
+    std::atomic<bool> stopping;
+
+    size_t chunkCount() const;
+    long long chunkPoints(size_t index) const;
+    // makes and maps the buffer for chunk index on the GL thread, false if the mapping failed
+    bool mapChunk(size_t index);
+    // where the producer writes chunk index, waits for the GL thread to map it first.
+    // nullptr if we are stopping before that happens
+    unsigned char *chunkMemory(size_t index);
+    void produce();
+
+public:
+    PointStream(long long iterations, uint64_t seed, ChaosKernel kernel, PointFormat format = PointFormat::Float3);
+    ~PointStream();
+
+    // sets up the first chunks on the current context and starts the producer
+    void start();
+
+    // call once a frame on the GL thread, returns how many points are safe to draw
+    long long update();
+
+    // draws the first count points, one draw per chunk. the VAO they go through has to be bound
+    void draw(long long count) const;
+
+    // bins points [first, first + count) into density, one dispatch per chunk
+    void accumulate(DensityRenderer &density, long long first, long long count) const;
+
+    bool finished() const;
+
+    // stops the producer and frees the buffers, has to run before the context goes away
+    void release();
+};
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef POSTERRENDERER_H
+#define POSTERRENDERER_H
+
+#include <cstdint>
+#include <string>
+
+#include "ChaosKernels.h"
+
+// renders the gasket's point density straight to a PNG on the CPU, no window or GL context needed
+// every thread runs the same walkers constructSierpinshi would give it, but bins each small batch of points into
+// its own histogram as soon as it's made, so the point list never exists. the histograms are summed in parallel
+// and tone mapped the same way as --density. images too big for a histogram per thread are binned by every thread
+// into one set of atomic counts instead. the gasket fills the shorter side of the image
+bool renderPoster(const std::string &path, int width, int height, long long iterations, unsigned int threadCount,
+                  uint64_t seed, ChaosKernel kernel);
+
+// pixel rectangle of a poster, top left corner first
+struct PosterTile {
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+};
+
+// same poster split into tiles, each rendered by a separate worker process (this executable started again with
+// --poster-tile) so one render can use every core, and later other machines, without the generator knowing.
+// workers hand their counts back through a mapped tile file, a worker that crashes or leaves a bad file has its
+// tile retried, and the coordinator stitches and tone maps the result. the image only depends on seed and size.
+// every worker is told to use kernel
+bool renderPosterTiled(const std::string &path, const std::string &executable, int width, int height, long long iterations,
+                       unsigned int workerCount, unsigned int threadCount, uint64_t seed, ChaosKernel kernel);
+
+// worker side, bins one tile's counts into tilePath. only the level k subtriangles touching the tile get points,
+// each one its fair share (iterations / 3^k) from its own seed, so a tile costs about its share of the whole render
+bool renderPosterTile(const std::string &tilePath, int width, int height, const PosterTile &tile, long long iterations,
+                      unsigned int threadCount, uint64_t seed, ChaosKernel kernel);
+
+#endif
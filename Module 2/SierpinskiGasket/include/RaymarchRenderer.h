@@ -0,0 +1,45 @@
+#ifndef RAYMARCHRENDERER_H
+#define RAYMARCHRENDERER_H
+
+// camera circling the origin, yaw around y and pitch above the xz plane (radians)
+struct OrbitCamera {
+    float yaw = 0.6f;
+    float pitch = 0.4f;
+    float distance = 4.0f;
+};
+
+// draws the 3D Sierpinski tetrahedron by ray marching a distance estimate in a fragment shader,
+// so the cost follows the pixel count instead of the 4^N tetrahedra. each frame only marches one pixel of
+// every 2x2 block and fills in the other three from the last frame's image moved to the new camera,
+// which keeps camera motion at a quarter of the rays while a still camera keeps refining the picture
+class RaymarchRenderer
+{
+private:
+    int width;
+    int height;
+
+    unsigned int traceProgram;
+    unsigned int resolveProgram;
+    unsigned int emptyVAO;
+
+    unsigned int traceFBO;
+    unsigned int traceTexture;      // half resolution, lit color and hit distance
+    unsigned int historyFBO[2];     // ping ponged, one is read while the other is written
+    unsigned int historyColor[2];   // color and how many samples went into it
+    unsigned int historyDepth[2];   // hit distance, the reprojection checks it before trusting the color
+    int current;
+
+    long long frame;
+    int historyLevels;              // fold depth the history was made with, changing it throws the history away
+    float previousBasis[4][3];      // position, right, up, forward of the last frame's camera
+
+public:
+    RaymarchRenderer(int width, int height);
+
+    // marches this frame's rays with levels folds and resolves them into the default framebuffer
+    void draw(const OrbitCamera &camera, int levels);
+
+    void release();
+};
+
+#endif
@@ -0,0 +1,244 @@
+#include "ChaosGame.h"
+#include "CoverageBitmap.h"
+#include "IFSKernels.h"
+#include "MortonOrder.h"
+
+#include <cmath>
+#include <thread>
+#include <vector>
+
+// points each thread adds per round of constructSierpinskiConverged, a multiple of CHAOS_WALKERS so the rounds
+// chain into the same points one long run would make
+static const long long CONVERGE_ROUND_POINTS = 1 << 15;
+
+// the screen counts as covered once fewer than one point in this many lands somewhere new, what is still dark
+// by then is mostly edge pixels the gasket only grazes
+static const long long CONVERGED_POINTS_PER_NEW_PIXEL = 10000;
+
+// stop regardless past this many points (800 MB of vertices), a screen far finer than the points can fill never settles
+static const long long MAX_CONVERGE_POINTS = 1LL << 26;
+
+// an IFS address prefix, the subtriangle it picks is offset + scale * gasket
+struct GasketCell {
+    double offsetX;
+    double offsetY;
+    double scale;
+};
+
+Pcg32::Pcg32(uint64_t seed, uint64_t stream){
+    state = 0;
+    increment = (stream << 1) | 1u; // increment has to be odd
+    next();
+    state += seed;
+    next();
+}
+
+uint32_t Pcg32::next(){
+    uint64_t oldState = state;
+    state = oldState * 6364136223846793005ULL + increment;
+    uint32_t xorShifted = static_cast<uint32_t>(((oldState >> 18) ^ oldState) >> 27);
+    uint32_t rotation = static_cast<uint32_t>(oldState >> 59);
+    return (xorShifted >> rotation) | (xorShifted << ((0u - rotation) & 31));
+}
+
+uint32_t Pcg32::nextBelow(uint32_t bound){
+    return static_cast<uint32_t>((static_cast<uint64_t>(next()) * bound) >> 32);
+}
+
+long long sierpinskiFloatCount(long long iterations){
+    return (iterations + 3) * 3;
+}
+
+void chaosGameChunk(float out[], long long count, uint64_t seed, uint64_t stream, ChaosKernel kernel){
+    ifsChunk<SierpinskiTriangle>(out, count, seed, stream, kernel);
+}
+
+void constructSierpinshi(long long iterations, float vertices[], unsigned int threadCount, uint64_t seed, ChaosKernel kernel,
+                         bool mortonOrder){
+    // shoving bounding triangle in first three of buffer
+    for(int i = 0; i < 3; i++){
+        vertices[(i * 3)] = TRIANGLE_X[i];
+        vertices[(i * 3) + 1] = TRIANGLE_Y[i];
+        vertices[(i * 3) + 2] = 0.0f; //z-coord
+    }
+    float *points = vertices + 9; // offset to jump past bounding triangle
+
+    constructIFS<SierpinskiTriangle>(iterations, points, threadCount, seed, kernel);
+    if(mortonOrder){
+        sortPointsMorton(points, iterations, threadCount);
+    }
+}
+
+// walks the vertex choices down to targetLevel keeping only subtriangles whose bounding box touches the view
+static void collectVisibleCells(const GasketCell &cell, int level, int targetLevel, double minX, double maxX, double minY,
+                                double maxY, std::vector<GasketCell> &cells){
+    double reach = cell.scale * 0.5; // the whole gasket sits in [-0.5, 0.5]^2
+    if(cell.offsetX + reach < minX || cell.offsetX - reach > maxX || cell.offsetY + reach < minY || cell.offsetY - reach > maxY){
+        return;
+    }
+    if(level == targetLevel){
+        cells.push_back(cell);
+        return;
+    }
+
+    // choosing vertex d first is (p + V_d) / 2, so the child is half the size moved halfway toward V_d
+    for(int d = 0; d < 3; d++){
+        GasketCell child = { cell.offsetX + cell.scale * 0.5 * TRIANGLE_X[d], cell.offsetY + cell.scale * 0.5 * TRIANGLE_Y[d],
+                             cell.scale * 0.5 };
+        collectVisibleCells(child, level + 1, targetLevel, minX, maxX, minY, maxY, cells);
+    }
+}
+
+void constructSierpinskiView(long long iterations, float vertices[], double centerX, double centerY, double zoom,
+                             unsigned int threadCount, uint64_t seed, ChaosKernel kernel){
+    // cells about half a screen wide keep the count small (a few dozen at most) while cutting off what's off screen
+    int targetLevel = std::max(0, static_cast<int>(std::floor(std::log2(zoom))));
+    double reach = 1.0 / zoom;
+    std::vector<GasketCell> cells;
+    collectVisibleCells({ 0.0, 0.0, 1.0 }, 0, targetLevel, centerX - reach, centerX + reach, centerY - reach, centerY + reach,
+                        cells);
+
+    constructIFS<SierpinskiTriangle>(iterations, vertices, threadCount, seed, kernel);
+    if(cells.empty()){
+        // looking at a hole or past the edge, park everything off screen
+        for(long long i = 0; i < iterations * 3; i++){
+            vertices[i] = 2.0f;
+        }
+        return;
+    }
+
+    // every cell is the same size so an even split keeps the density even
+    // screen position is worked out in doubles relative to the center, floats only ever hold the final screen value
+    long long perCell = iterations / static_cast<long long>(cells.size());
+    long long extra = iterations % static_cast<long long>(cells.size());
+    long long point = 0;
+    for(size_t c = 0; c < cells.size(); c++){
+        long long count = perCell + ((static_cast<long long>(c) < extra) ? 1 : 0);
+        double relativeX = cells[c].offsetX - centerX;
+        double relativeY = cells[c].offsetY - centerY;
+        for(long long i = 0; i < count; i++, point++){
+            float *vertex = vertices + point * 3;
+            vertex[0] = static_cast<float>((relativeX + cells[c].scale * vertex[0]) * zoom);
+            vertex[1] = static_cast<float>((relativeY + cells[c].scale * vertex[1]) * zoom);
+        }
+    }
+}
+
+long long constructSierpinskiConverged(std::vector<float> &vertices, int width, int height, unsigned int threadCount,
+                                       uint64_t seed, ChaosKernel kernel, bool mortonOrder){
+    if(threadCount == 0){
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // every thread keeps its own walkers and points, the bitmap is the only thing they share
+    CoverageBitmap coverage(width, height);
+    std::vector<WalkerState> walkers(threadCount);
+    std::vector<std::vector<float>> threadPoints(threadCount);
+    std::vector<long long> newPixels(threadCount);
+    for(unsigned int t = 0; t < threadCount; t++){
+        initIFSWalkers<SierpinskiTriangle>(walkers[t], seed, t);
+    }
+
+    auto round = [&](unsigned int t){
+        std::vector<float> &points = threadPoints[t];
+        size_t first = points.size();
+        points.resize(first + CONVERGE_ROUND_POINTS * 3);
+        runIFSKernel<SierpinskiTriangle>(kernel, walkers[t], points.data() + first, CONVERGE_ROUND_POINTS);
+        long long found = 0;
+        for(size_t i = first; i < points.size(); i += 3){
+            found += coverage.mark(points[i], points[i + 1]) ? 1 : 0;
+        }
+        newPixels[t] = found;
+    };
+
+    long long iterations = 0;
+    long long roundPoints = CONVERGE_ROUND_POINTS * threadCount;
+    while(iterations + roundPoints <= MAX_CONVERGE_POINTS){
+        std::vector<std::thread> workers;
+        for(unsigned int t = 1; t < threadCount; t++){
+            workers.emplace_back(round, t);
+        }
+        round(0);
+        for(std::thread &worker : workers){
+            worker.join();
+        }
+        iterations += roundPoints;
+
+        long long found = 0;
+        for(long long count : newPixels){
+            found += count;
+        }
+        if(found * CONVERGED_POINTS_PER_NEW_PIXEL < roundPoints){
+            break;
+        }
+    }
+
+    // bounding triangle first like constructSierpinshi, then each thread's points in turn
+    vertices.clear();
+    vertices.reserve(sierpinskiFloatCount(iterations));
+    for(int i = 0; i < 3; i++){
+        vertices.push_back(TRIANGLE_X[i]);
+        vertices.push_back(TRIANGLE_Y[i]);
+        vertices.push_back(0.0f);
+    }
+    for(std::vector<float> &points : threadPoints){
+        vertices.insert(vertices.end(), points.begin(), points.end());
+        std::vector<float>().swap(points);
+    }
+    if(mortonOrder){
+        sortPointsMorton(vertices.data() + 9, iterations, threadCount);
+    }
+    return iterations;
+}
+
+long long fractalFloatCount(FractalType fractal, long long iterations){
+    if(fractal == FractalType::Sierpinski){
+        return sierpinskiFloatCount(iterations);
+    }
+    return iterations * 3;
+}
+
+void constructFractal(FractalType fractal, long long iterations, float vertices[], unsigned int threadCount, uint64_t seed,
+                      ChaosKernel kernel, bool mortonOrder){
+    switch(fractal){
+        case FractalType::Pentagon:
+            constructIFS<PolygonFlake<5>>(iterations, vertices, threadCount, seed, kernel);
+        break;
+        case FractalType::Hexagon:
+            constructIFS<PolygonFlake<6>>(iterations, vertices, threadCount, seed, kernel);
+        break;
+        case FractalType::Carpet:
+            constructIFS<SierpinskiCarpet>(iterations, vertices, threadCount, seed, kernel);
+        break;
+        case FractalType::Fern:
+            constructIFS<BarnsleyFern>(iterations, vertices, threadCount, seed, kernel);
+        break;
+        case FractalType::Tetrahedron:
+            constructIFS<SierpinskiTetrahedron>(iterations, vertices, threadCount, seed, kernel);
+        break;
+        default:
+            constructSierpinshi(iterations, vertices, threadCount, seed, kernel, mortonOrder);
+            return;
+    }
+
+    if(mortonOrder){
+        sortPointsMorton(vertices, iterations, threadCount);
+    }
+}
+
+const char *fractalName(FractalType fractal){
+    switch(fractal){
+        case FractalType::Pentagon:
+            return "pentagon";
+        case FractalType::Hexagon:
+            return "hexagon";
+        case FractalType::Carpet:
+            return "carpet";
+        case FractalType::Fern:
+            return "fern";
+        case FractalType::Tetrahedron:
+            return "tetrahedron";
+        default:
+            return "sierpinski";
+    }
+}
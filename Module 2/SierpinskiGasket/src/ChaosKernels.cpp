@@ -0,0 +1,60 @@
+#include "ChaosKernels.h"
+#include "IFSKernels.h"
+
+const float TRIANGLE_X[3] = { -0.5f, 0.0f,  0.5f };
+const float TRIANGLE_Y[3] = { -0.5f, 0.5f, -0.5f };
+
+void initWalkers(WalkerState &walkers, uint64_t seed, uint64_t stream){
+    initIFSWalkers<SierpinskiTriangle>(walkers, seed, stream);
+}
+
+void runChaosKernel(ChaosKernel kernel, WalkerState &walkers, float out[], long long count){
+    runIFSKernel<SierpinskiTriangle>(kernel, walkers, out, count);
+}
+
+bool chaosKernelSupported(ChaosKernel kernel){
+    switch(kernel){
+#if CHAOS_X86
+        case ChaosKernel::AVX512:
+            return __builtin_cpu_supports("avx512f");
+        case ChaosKernel::AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        case ChaosKernel::Scalar:
+            return true;
+        default:
+            return false;
+    }
+}
+
+ChaosKernel detectChaosKernel(){
+    if(chaosKernelSupported(ChaosKernel::AVX512)){
+        return ChaosKernel::AVX512;
+    }
+    if(chaosKernelSupported(ChaosKernel::AVX2)){
+        return ChaosKernel::AVX2;
+    }
+    return ChaosKernel::Scalar;
+}
+
+const char *chaosKernelName(ChaosKernel kernel){
+    switch(kernel){
+        case ChaosKernel::AVX512:
+            return "AVX-512";
+        case ChaosKernel::AVX2:
+            return "AVX2";
+        default:
+            return "scalar";
+    }
+}
+
+const char *chaosKernelArgument(ChaosKernel kernel){
+    switch(kernel){
+        case ChaosKernel::AVX512:
+            return "avx512";
+        case ChaosKernel::AVX2:
+            return "avx2";
+        default:
+            return "scalar";
+    }
+}
@@ -0,0 +1,273 @@
+#include "CloudStreamer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+// enough for the gasket to read as solid where it is dense without drawing the same pixel over and over
+static const double POINTS_PER_PIXEL = 4.0;
+
+// the sampled fraction is rounded down to one of this many steps an octave, so a small pan keeps the same fraction
+// and the leaves still on screen can be copied over from the front buffer instead of coming from the file again
+static const double FRACTION_STEPS_PER_OCTAVE = 8.0;
+
+CloudStreamer::CloudStreamer(const PointCloudFile &cloud, long long budget)
+    : cloud(cloud), budget(budget), persistent(false), front(0), backFence(0), gatheredWidth(0), gatheredHeight(0),
+      gathered(false), stopping(false){
+}
+
+CloudStreamer::~CloudStreamer(){
+    stopping = true;
+    if(gatherer.joinable()){
+        gatherer.join();
+    }
+}
+
+void CloudStreamer::start(){
+    GLsizeiptr bufferSize = budget * pointFormatStride(cloud.format());
+
+    // same as the point stream, GL 4.4 lets the worker write straight into the buffers
+    persistent = GLAD_GL_VERSION_4_4;
+    for(Slot &slot : slots){
+        glGenBuffers(1, &slot.VBO);
+        glBindBuffer(GL_ARRAY_BUFFER, slot.VBO);
+        if(persistent){
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_ARRAY_BUFFER, bufferSize, NULL, flags);
+            slot.mapped = static_cast<unsigned char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, bufferSize, flags));
+            if(!slot.mapped){
+                std::cout << "ERROR: PERSISTENT MAPPING FAILED, FALLING BACK TO BUFFER UPLOADS" << std::endl;
+                persistent = false;
+            }
+        }
+    }
+
+    if(!persistent){
+        // storage made with glBufferStorage can't be resized, so both buffers start over as plain ones
+        for(Slot &slot : slots){
+            if(slot.mapped){
+                glBindBuffer(GL_ARRAY_BUFFER, slot.VBO);
+                glUnmapBuffer(GL_ARRAY_BUFFER);
+                slot.mapped = nullptr;
+            }
+            glDeleteBuffers(1, &slot.VBO);
+            glGenBuffers(1, &slot.VBO);
+            glBindBuffer(GL_ARRAY_BUFFER, slot.VBO);
+            glBufferData(GL_ARRAY_BUFFER, bufferSize, NULL, GL_DYNAMIC_DRAW);
+        }
+        // only the points that come from the file land here, and every one is written before it's uploaded
+        staging.reset(new unsigned char[bufferSize]);
+    }
+}
+
+// node is the Z order number of the cell at this level, (x, y) its lower left corner
+void CloudStreamer::collect(std::vector<LeafRun> &runs, int level, long long node, double x, double y, double minX,
+                            double maxX, double minY, double maxY) const{
+    double size = 1.0 / static_cast<double>(1LL << level);
+    if(x > maxX || x + size < minX || y > maxY || y + size < minY){
+        return;
+    }
+
+    int levelsBelow = cloud.depth() - level;
+    long long firstLeaf = node << (2 * levelsBelow);
+    long long lastLeaf = (node + 1) << (2 * levelsBelow);
+    if(cloud.leafBegin(firstLeaf) == cloud.leafBegin(lastLeaf)){
+        return; // nothing in here, most of the gasket's holes end up like this
+    }
+
+    bool inside = x >= minX && x + size <= maxX && y >= minY && y + size <= maxY;
+    if(inside || levelsBelow == 0){
+        // children come in Z order so a run either extends the last one or starts after it
+        if(!runs.empty() && runs.back().lastLeaf == firstLeaf){
+            runs.back().lastLeaf = lastLeaf;
+        } else{
+            runs.push_back({ firstLeaf, lastLeaf });
+        }
+        return;
+    }
+
+    double half = size * 0.5;
+    for(int child = 0; child < 4; child++){
+        // x goes in the even bit of the Z order number
+        double childX = x + ((child & 1) ? half : 0.0);
+        double childY = y + ((child & 2) ? half : 0.0);
+        collect(runs, level + 1, (node << 2) | child, childX, childY, minX, maxX, minY, maxY);
+    }
+}
+
+void CloudStreamer::gather(GasketView view, int width, int height){
+    const Slot &shown = slots[front];
+    Slot &back = slots[1 - front];
+
+    // the screen is 2 / zoom wide in gasket units, same as the analytic mode
+    back.runs.clear();
+    double reach = 1.0 / view.zoom;
+    collect(back.runs, 0, 0, -0.5, -0.5, view.centerX - reach, view.centerX + reach, view.centerY - reach,
+            view.centerY + reach);
+
+    long long visible = 0;
+    for(const LeafRun &run : back.runs){
+        visible += cloud.leafBegin(run.lastLeaf) - cloud.leafBegin(run.firstLeaf);
+    }
+    long long wanted = std::min(budget, static_cast<long long>(width * static_cast<double>(height) * POINTS_PER_PIXEL));
+    back.fraction = 1.0;
+    if(visible > wanted){
+        double octaves = std::floor(std::log2(static_cast<double>(wanted) / visible) * FRACTION_STEPS_PER_OCTAVE);
+        back.fraction = std::exp2(octaves / FRACTION_STEPS_PER_OCTAVE);
+    }
+
+    // the first part of every leaf, leaves are in generation order so that is an even sample
+    auto take = [&](long long leaf, double fraction){
+        long long count = cloud.leafBegin(leaf + 1) - cloud.leafBegin(leaf);
+        return fraction >= 1.0 ? count : static_cast<long long>(std::ceil(count * fraction));
+    };
+
+    // leaves the front buffer holds with the same fraction are copied over on the GPU. both lists are in Z order
+    // so one cursor walking the front's leaves alongside ours finds them
+    bool reuse = shown.fraction == back.fraction;
+    size_t shownRun = 0;
+    long long shownLeaf = shown.runs.empty() ? 0 : shown.runs[0].firstLeaf;
+    long long shownOffset = 0;
+
+    copies.clear();
+    long long written = 0;
+    for(const LeafRun &run : back.runs){
+        for(long long leaf = run.firstLeaf; leaf < run.lastLeaf && written < budget && !stopping; leaf++){
+            long long count = std::min(budget - written, take(leaf, back.fraction));
+            if(count == 0){
+                continue;
+            }
+
+            bool resident = false;
+            long long source = cloud.leafBegin(leaf);
+            if(reuse){
+                while(shownRun < shown.runs.size() && shownLeaf < leaf){
+                    shownOffset += take(shownLeaf, shown.fraction);
+                    if(++shownLeaf == shown.runs[shownRun].lastLeaf && ++shownRun < shown.runs.size()){
+                        shownLeaf = shown.runs[shownRun].firstLeaf;
+                    }
+                }
+                resident = shownRun < shown.runs.size() && shownLeaf == leaf && shownOffset + count <= shown.written;
+                if(resident){
+                    source = shownOffset;
+                }
+            }
+
+            // neighbouring leaves usually sit next to each other at both ends, so they make one copy
+            Copy *last = copies.empty() ? nullptr : &copies.back();
+            if(last && last->fromFront == resident && last->source + last->count == source
+               && last->dest + last->count == written){
+                last->count += count;
+            } else{
+                copies.push_back({ resident, source, written, count });
+            }
+            written += count;
+        }
+    }
+    back.written = written;
+
+    // the mapped file only pages in the leaves we copy from here, off the render thread
+    size_t stride = pointFormatStride(cloud.format());
+    unsigned char *out = persistent ? back.mapped : staging.get();
+    for(const Copy &copy : copies){
+        if(stopping){
+            break;
+        }
+        if(!copy.fromFront){
+            std::memcpy(out + copy.dest * stride, cloud.point(copy.source), copy.count * stride);
+        }
+    }
+
+    gathered.store(true, std::memory_order_release);
+}
+
+bool CloudStreamer::backIdle(){
+    if(!backFence){
+        return true;
+    }
+    GLenum state = glClientWaitSync(backFence, 0, 0);
+    if(state != GL_ALREADY_SIGNALED && state != GL_CONDITION_SATISFIED){
+        return false;
+    }
+    glDeleteSync(backFence);
+    backFence = 0;
+    return true;
+}
+
+void CloudStreamer::swap(){
+    const Slot &shown = slots[front];
+    const Slot &back = slots[1 - front];
+    size_t stride = pointFormatStride(cloud.format());
+
+    // resident leaves never leave the GPU, the rest was written by the worker or waits in staging
+    glBindBuffer(GL_COPY_READ_BUFFER, shown.VBO);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, back.VBO);
+    for(const Copy &copy : copies){
+        if(copy.fromFront){
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, copy.source * stride, copy.dest * stride,
+                                copy.count * stride);
+        } else if(!persistent){
+            glBufferSubData(GL_COPY_WRITE_BUFFER, copy.dest * stride, copy.count * stride, staging.get() + copy.dest * stride);
+        }
+    }
+    front = 1 - front;
+
+    // the old front is still queued for drawing, the next gather can't write over it until that's done
+    if(persistent){
+        backFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+}
+
+void CloudStreamer::update(const GasketView &view, int width, int height){
+    if(gatherer.joinable() && gathered.load(std::memory_order_acquire)){
+        gatherer.join();
+        swap();
+    }
+
+    bool moved = view.centerX != gatheredView.centerX || view.centerY != gatheredView.centerY
+                 || view.zoom != gatheredView.zoom || width != gatheredWidth || height != gatheredHeight;
+    if(!moved || gatherer.joinable() || !backIdle()){
+        // the front buffer stays up until the next gather lands
+        return;
+    }
+    gatheredView = view;
+    gatheredWidth = width;
+    gatheredHeight = height;
+    gathered = false;
+    gatherer = std::thread(&CloudStreamer::gather, this, view, width, height);
+}
+
+void CloudStreamer::draw() const{
+    const Slot &shown = slots[front];
+    if(shown.written == 0){
+        return;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, shown.VBO);
+    setPointAttribute(cloud.format());
+    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(shown.written));
+}
+
+void CloudStreamer::release(){
+    stopping = true;
+    if(gatherer.joinable()){
+        gatherer.join();
+    }
+    if(backFence){
+        glDeleteSync(backFence);
+        backFence = 0;
+    }
+    for(Slot &slot : slots){
+        if(slot.VBO == 0){
+            continue;
+        }
+        if(slot.mapped){
+            glBindBuffer(GL_ARRAY_BUFFER, slot.VBO);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+            slot.mapped = nullptr;
+        }
+        glDeleteBuffers(1, &slot.VBO);
+        slot.VBO = 0;
+    }
+    staging.reset();
+}
@@ -0,0 +1,20 @@
+#include "CoverageBitmap.h"
+
+#include <bitset>
+
+CoverageBitmap::CoverageBitmap(int width, int height) : width(width), height(height){
+    long long wordCount = (static_cast<long long>(width) * height + 63) / 64;
+    words.reset(new std::atomic<uint64_t>[wordCount]);
+    for(long long i = 0; i < wordCount; i++){
+        words[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+long long CoverageBitmap::coveredPixels() const{
+    long long wordCount = (static_cast<long long>(width) * height + 63) / 64;
+    long long covered = 0;
+    for(long long i = 0; i < wordCount; i++){
+        covered += static_cast<long long>(std::bitset<64>(words[i].load(std::memory_order_relaxed)).count());
+    }
+    return covered;
+}
@@ -0,0 +1,93 @@
+#include "DensityRenderer.h"
+#include "GasketShaders.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <glad/glad.h>
+
+// has to match local_size_x in densityComputeSource
+static const long long GROUP_SIZE = 256;
+
+// the spec only promises 65535 groups along x, bigger dispatches wrap onto y
+static const long long MAX_GROUPS_X = 65535;
+
+DensityRenderer::DensityRenderer(int width, int height) : width(width), height(height){
+    accumulateProgram = compileComputeProgram(densityComputeSource);
+    toneMapProgram = compileProgram(fullscreenVertexSource, toneMapFragmentSource);
+
+    // counters start at zero
+    std::vector<uint32_t> zeros(static_cast<size_t>(width) * height, 0u);
+    glGenTextures(1, &densityTexture);
+    glBindTexture(GL_TEXTURE_2D, densityTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, width, height, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, zeros.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    uint32_t peak = 0;
+    glGenBuffers(1, &peakBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, peakBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(peak), &peak, GL_DYNAMIC_COPY);
+
+    // the tone map triangle has no attributes but core profile still wants a VAO bound
+    glGenVertexArrays(1, &emptyVAO);
+}
+
+bool DensityRenderer::supported(){
+    return GLAD_GL_VERSION_4_3;
+}
+
+void DensityRenderer::dispatch(long long first, long long count){
+    glBindImageTexture(0, densityTexture, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32UI);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, peakBuffer);
+    glUniform1ui(glGetUniformLocation(accumulateProgram, "firstPoint"), static_cast<unsigned int>(first));
+    glUniform1ui(glGetUniformLocation(accumulateProgram, "pointCount"), static_cast<unsigned int>(count));
+
+    long long groups = (count + GROUP_SIZE - 1) / GROUP_SIZE;
+    long long groupsX = std::min(groups, MAX_GROUPS_X);
+    long long groupsY = (groups + groupsX - 1) / groupsX;
+    glDispatchCompute(static_cast<unsigned int>(groupsX), static_cast<unsigned int>(groupsY), 1);
+
+    // the tone map reads both the counters and the peak after this
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+}
+
+void DensityRenderer::accumulate(unsigned int pointBuffer, PointFormat format, long long first, long long count){
+    if(count <= 0){
+        return;
+    }
+    glUseProgram(accumulateProgram);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, pointBuffer);
+    glUniform1i(glGetUniformLocation(accumulateProgram, "generate"), GL_FALSE);
+    glUniform1i(glGetUniformLocation(accumulateProgram, "pointFormat"), static_cast<int>(format));
+    glUniform1f(glGetUniformLocation(accumulateProgram, "positionScale"), pointFormatScale(format));
+    dispatch(first, count);
+}
+
+void DensityRenderer::accumulateGenerated(long long count, uint32_t seed, int depth){
+    if(count <= 0){
+        return;
+    }
+    glUseProgram(accumulateProgram);
+    glUniform1i(glGetUniformLocation(accumulateProgram, "generate"), GL_TRUE);
+    glUniform1ui(glGetUniformLocation(accumulateProgram, "seed"), seed);
+    glUniform1i(glGetUniformLocation(accumulateProgram, "depth"), depth);
+    dispatch(0, count);
+}
+
+void DensityRenderer::draw(){
+    glUseProgram(toneMapProgram);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, densityTexture);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, peakBuffer);
+    glBindVertexArray(emptyVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+void DensityRenderer::release(){
+    glDeleteTextures(1, &densityTexture);
+    glDeleteBuffers(1, &peakBuffer);
+    glDeleteVertexArrays(1, &emptyVAO);
+    glDeleteProgram(accumulateProgram);
+    glDeleteProgram(toneMapProgram);
+}
@@ -0,0 +1,160 @@
+#include "GasketMesh.h"
+#include "ChaosKernels.h"
+
+#include <algorithm>
+#include <thread>
+
+// a triangle still to be subdivided, corners are known and the vertices / triangles it makes
+// start at fixed offsets in the output
+struct MeshTask {
+    int level;
+    uint32_t corner[3];
+    float x[3];
+    float y[3];
+    long long vertexOffset;
+    long long triangleOffset;
+};
+
+// subtrees this small are not worth handing to their own thread
+static const int MIN_TASK_LEVEL = 4;
+
+int GasketMesh::indexSize() const{
+    return shortIndices.empty() && !indices.empty() ? 4 : 2;
+}
+
+long long GasketMesh::indexCount() const{
+    return indexSize() == 2 ? shortIndices.size() : indices.size();
+}
+
+const void *GasketMesh::indexData() const{
+    return indexSize() == 2 ? static_cast<const void*>(shortIndices.data()) : static_cast<const void*>(indices.data());
+}
+
+long long gasketMeshTriangleCount(int level){
+    long long triangles = 1;
+    for(int i = 0; i < level; i++){
+        triangles *= 3;
+    }
+    return triangles;
+}
+
+// midpoints a level n triangle adds below itself: 3 of its own plus three level n - 1 subtrees
+static long long midpointCount(int level){
+    return 3 * (gasketMeshTriangleCount(level) - 1) / 2;
+}
+
+long long gasketMeshVertexCount(int level){
+    return 3 + midpointCount(level);
+}
+
+// splits a task into its three corner subtriangles, child k gets the k-th block of vertices and triangles
+static void splitTask(const MeshTask &task, float vertices[], MeshTask children[3]){
+    uint32_t mid[3];
+    float midX[3];
+    float midY[3];
+    for(int edge = 0; edge < 3; edge++){
+        int next = (edge + 1) % 3;
+        mid[edge] = static_cast<uint32_t>(task.vertexOffset + edge);
+        midX[edge] = (task.x[edge] + task.x[next]) * 0.5f;
+        midY[edge] = (task.y[edge] + task.y[next]) * 0.5f;
+
+        vertices[(mid[edge] * 3)] = midX[edge];
+        vertices[(mid[edge] * 3) + 1] = midY[edge];
+        vertices[(mid[edge] * 3) + 2] = 0.0f; // staying 2D so z axis needs to be zero
+    }
+
+    // corner k keeps its own vertex and takes the midpoints of the two edges touching it
+    for(int k = 0; k < 3; k++){
+        int previous = (k + 2) % 3;
+        MeshTask &child = children[k];
+        child.level = task.level - 1;
+        child.corner[0] = task.corner[k];
+        child.corner[1] = mid[k];
+        child.corner[2] = mid[previous];
+        child.x[0] = task.x[k];
+        child.x[1] = midX[k];
+        child.x[2] = midX[previous];
+        child.y[0] = task.y[k];
+        child.y[1] = midY[k];
+        child.y[2] = midY[previous];
+        child.vertexOffset = task.vertexOffset + 3 + k * midpointCount(child.level);
+        child.triangleOffset = task.triangleOffset + k * gasketMeshTriangleCount(child.level);
+    }
+}
+
+template <typename Index>
+static void buildSubtree(const MeshTask &task, float vertices[], Index indices[]){
+    if(task.level == 0){
+        for(int i = 0; i < 3; i++){
+            indices[(task.triangleOffset * 3) + i] = static_cast<Index>(task.corner[i]);
+        }
+        return;
+    }
+
+    MeshTask children[3];
+    splitTask(task, vertices, children);
+    for(int k = 0; k < 3; k++){
+        buildSubtree(children[k], vertices, indices);
+    }
+}
+
+template <typename Index>
+static void buildMesh(GasketMesh &mesh, std::vector<Index> &indices, unsigned int threadCount){
+    indices.resize(gasketMeshTriangleCount(mesh.level) * 3);
+
+    MeshTask root;
+    root.level = mesh.level;
+    for(int i = 0; i < 3; i++){
+        root.corner[i] = i;
+        root.x[i] = TRIANGLE_X[i];
+        root.y[i] = TRIANGLE_Y[i];
+        mesh.vertices[(i * 3)] = TRIANGLE_X[i];
+        mesh.vertices[(i * 3) + 1] = TRIANGLE_Y[i];
+        mesh.vertices[(i * 3) + 2] = 0.0f;
+    }
+    root.vertexOffset = 3;
+    root.triangleOffset = 0;
+
+    // split the top levels on this thread until there are a few subtrees per worker
+    std::vector<MeshTask> tasks = { root };
+    while(tasks.size() < threadCount * 4 && tasks[0].level > MIN_TASK_LEVEL){
+        std::vector<MeshTask> children(tasks.size() * 3);
+        for(size_t t = 0; t < tasks.size(); t++){
+            splitTask(tasks[t], mesh.vertices.data(), &children[t * 3]);
+        }
+        tasks.swap(children);
+    }
+
+    // every subtree writes its own ranges so the workers never touch the same memory
+    auto worker = [&](unsigned int first){
+        for(size_t t = first; t < tasks.size(); t += threadCount){
+            buildSubtree(tasks[t], mesh.vertices.data(), indices.data());
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for(unsigned int t = 1; t < std::min<size_t>(threadCount, tasks.size()); t++){
+        workers.emplace_back(worker, t);
+    }
+    worker(0);
+    for(std::thread &thread : workers){
+        thread.join();
+    }
+}
+
+GasketMesh buildGasketMesh(int level, unsigned int threadCount){
+    if(threadCount == 0){
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    GasketMesh mesh;
+    mesh.level = std::max(level, 0);
+    mesh.vertices.resize(gasketMeshVertexCount(mesh.level) * 3);
+
+    if(gasketMeshVertexCount(mesh.level) <= 65536){
+        buildMesh(mesh, mesh.shortIndices, threadCount);
+    } else{
+        buildMesh(mesh, mesh.indices, threadCount);
+    }
+    return mesh;
+}
@@ -0,0 +1,238 @@
+#include "GasketSettings.h"
+#include "PointCloudFile.h"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <ctime>
+
+// gpu points are numbered with a 32 bit uint, past that the same points come round again
+static const long long MAX_GPU_POINTS = 0xFFFFFFFFLL;
+
+GasketSettings parseSettings(int argc, char *argv[]){
+    GasketSettings settings;
+    settings.seed = static_cast<uint64_t>(time(0));
+    settings.kernel = detectChaosKernel();
+
+    for(int i = 1; i < argc; i++){
+        std::string argument = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        try{
+            if(argument == "--points" && hasValue && std::string(argv[i + 1]) == "auto"){
+                settings.converge = true;
+                i++;
+            } else if(argument == "--points" && hasValue){
+                settings.iterations = std::stoll(argv[++i]);
+                settings.converge = false;
+            } else if(argument == "--threads" && hasValue){
+                settings.threads = static_cast<unsigned int>(std::stoul(argv[++i]));
+            } else if(argument == "--seed" && hasValue){
+                settings.seed = std::stoull(argv[++i]);
+            } else if(argument == "--mode" && hasValue){
+                std::string name = argv[++i];
+                if(name == "points"){
+                    settings.mode = RenderMode::Points;
+                } else if(name == "gpu"){
+                    settings.mode = RenderMode::GpuPoints;
+                } else if(name == "mesh"){
+                    settings.mode = RenderMode::Mesh;
+                } else if(name == "instanced"){
+                    settings.mode = RenderMode::Instanced;
+                } else if(name == "analytic"){
+                    settings.mode = RenderMode::Analytic;
+                } else if(name == "view"){
+                    settings.mode = RenderMode::ViewPoints;
+                } else if(name == "raymarch"){
+                    settings.mode = RenderMode::Raymarch;
+                } else{
+                    std::cout << "ERROR: UNKNOWN MODE " << name << std::endl;
+                }
+            } else if(argument == "--level" && hasValue){
+                settings.level = std::stoi(argv[++i]);
+            } else if(argument == "--center" && i + 2 < argc){
+                settings.view.centerX = std::stod(argv[++i]);
+                settings.view.centerY = std::stod(argv[++i]);
+            } else if(argument == "--zoom" && hasValue){
+                settings.view.zoom = std::stod(argv[++i]);
+            } else if(argument == "--stream"){
+                settings.stream = true;
+            } else if(argument == "--density"){
+                settings.density = true;
+            } else if(argument == "--morton"){
+                settings.morton = true;
+            } else if(argument == "--benchmark"){
+                settings.benchmark = true;
+            } else if(argument == "--cloud" && hasValue){
+                settings.cloudPath = argv[++i];
+            } else if(argument == "--cloud-depth" && hasValue){
+                settings.cloudDepth = std::stoi(argv[++i]);
+            } else if(argument == "--poster" && hasValue){
+                settings.posterPath = argv[++i];
+            } else if(argument == "--poster-size" && i + 2 < argc){
+                settings.posterWidth = std::stoi(argv[++i]);
+                settings.posterHeight = std::stoi(argv[++i]);
+            } else if(argument == "--poster-workers" && hasValue){
+                settings.posterWorkers = static_cast<unsigned int>(std::stoul(argv[++i]));
+            } else if(argument == "--poster-tile" && i + 5 < argc){
+                settings.posterTilePath = argv[++i];
+                settings.posterTile.x = std::stoi(argv[++i]);
+                settings.posterTile.y = std::stoi(argv[++i]);
+                settings.posterTile.width = std::stoi(argv[++i]);
+                settings.posterTile.height = std::stoi(argv[++i]);
+            } else if(argument == "--kernel" && hasValue){
+                std::string name = argv[++i];
+                ChaosKernel requested = settings.kernel;
+                if(name == "scalar"){
+                    requested = ChaosKernel::Scalar;
+                } else if(name == "avx2"){
+                    requested = ChaosKernel::AVX2;
+                } else if(name == "avx512"){
+                    requested = ChaosKernel::AVX512;
+                } else if(name != "auto"){
+                    std::cout << "ERROR: UNKNOWN KERNEL " << name << std::endl;
+                }
+
+                if(chaosKernelSupported(requested)){
+                    settings.kernel = requested;
+                } else{
+                    std::cout << "WARNING: this CPU can't run the " << chaosKernelName(requested) << " kernel" << std::endl;
+                }
+            } else if(argument == "--fractal" && hasValue){
+                std::string name = argv[++i];
+                if(name == "sierpinski"){
+                    settings.fractal = FractalType::Sierpinski;
+                } else if(name == "pentagon"){
+                    settings.fractal = FractalType::Pentagon;
+                } else if(name == "hexagon"){
+                    settings.fractal = FractalType::Hexagon;
+                } else if(name == "carpet"){
+                    settings.fractal = FractalType::Carpet;
+                } else if(name == "fern"){
+                    settings.fractal = FractalType::Fern;
+                } else if(name == "tetrahedron"){
+                    settings.fractal = FractalType::Tetrahedron;
+                } else{
+                    std::cout << "ERROR: UNKNOWN FRACTAL " << name << std::endl;
+                }
+            } else if(argument == "--format" && hasValue){
+                std::string name = argv[++i];
+                if(name == "xyz"){
+                    settings.format = PointFormat::Float3;
+                } else if(name == "xy"){
+                    settings.format = PointFormat::Float2;
+                } else if(name == "half"){
+                    settings.format = PointFormat::Half2;
+                } else if(name == "short"){
+                    settings.format = PointFormat::Short2;
+                } else{
+                    std::cout << "ERROR: UNKNOWN FORMAT " << name << std::endl;
+                }
+            } else{
+                std::cout << "WARNING: ignoring argument " << argument << std::endl;
+            }
+        }
+        catch(std::exception &e){
+            std::cout << "ERROR: BAD VALUE FOR " << argument << std::endl;
+        }
+    }
+
+    if(settings.iterations < 0){
+        settings.iterations = 0;
+    }
+
+    // streaming only makes sense when the CPU is the one making points
+    if(settings.stream && settings.mode != RenderMode::Points){
+        std::cout << "WARNING: --stream only works with --mode points" << std::endl;
+        settings.stream = false;
+    }
+
+    // the count comes from the window, so it only works where the CPU makes every point up front for the gasket
+    if(settings.converge && (settings.mode != RenderMode::Points || settings.stream || !settings.cloudPath.empty()
+                             || settings.benchmark || !settings.posterPath.empty() || settings.fractal != FractalType::Sierpinski)){
+        std::cout << "WARNING: --points auto only works with --mode points for the gasket without --stream, --cloud, --benchmark"
+                  << " or --poster" << std::endl;
+        settings.converge = false;
+    }
+
+    // sorting needs every point up front, so neither works on a stream
+    if((settings.morton || settings.benchmark) && (settings.mode != RenderMode::Points || settings.stream)){
+        std::cout << "WARNING: --morton and --benchmark only work with --mode points without --stream" << std::endl;
+        settings.morton = false;
+        settings.benchmark = false;
+    }
+
+    // the cloud streamer owns the vertex buffer and refills it whenever the view moves
+    if(!settings.cloudPath.empty() && (settings.mode != RenderMode::Points || settings.stream || settings.density
+                                       || settings.morton || settings.benchmark)){
+        std::cout << "WARNING: --cloud only works with --mode points without --stream, --density, --morton or --benchmark"
+                  << std::endl;
+        settings.cloudPath.clear();
+    }
+
+    if(settings.cloudDepth < 1 || settings.cloudDepth > MAX_CLOUD_DEPTH){
+        std::cout << "WARNING: cloud depth has to be between 1 and " << MAX_CLOUD_DEPTH << std::endl;
+        settings.cloudDepth = std::max(1, std::min(settings.cloudDepth, MAX_CLOUD_DEPTH));
+    }
+
+    if(settings.mode == RenderMode::GpuPoints && settings.iterations > MAX_GPU_POINTS){
+        std::cout << "WARNING: --mode gpu makes at most " << MAX_GPU_POINTS << " points" << std::endl;
+        settings.iterations = MAX_GPU_POINTS;
+    }
+
+    // the other modes either upload nothing or need their z
+    if(settings.format != PointFormat::Float3 && settings.mode != RenderMode::Points){
+        std::cout << "WARNING: --format only works with --mode points" << std::endl;
+        settings.format = PointFormat::Float3;
+    }
+
+    // every other mode and the stream are built around the gasket
+    if(settings.fractal != FractalType::Sierpinski && (settings.mode != RenderMode::Points || settings.stream)){
+        std::cout << "WARNING: --fractal only works with --mode points without --stream" << std::endl;
+        settings.fractal = FractalType::Sierpinski;
+    }
+
+    // posters bin constructSierpinshi's points and never open a window, so none of the drawing options apply
+    if((!settings.posterPath.empty() || !settings.posterTilePath.empty()) && settings.fractal != FractalType::Sierpinski){
+        std::cout << "WARNING: --poster only draws the sierpinski gasket" << std::endl;
+        settings.fractal = FractalType::Sierpinski;
+    }
+
+    if(settings.posterWorkers > 0 && settings.posterPath.empty()){
+        std::cout << "WARNING: --poster-workers only works with --poster" << std::endl;
+        settings.posterWorkers = 0;
+    }
+
+    if(settings.posterWidth < 1 || settings.posterHeight < 1){
+        std::cout << "WARNING: poster size has to be positive" << std::endl;
+        settings.posterWidth = std::max(1, settings.posterWidth);
+        settings.posterHeight = std::max(1, settings.posterHeight);
+    }
+
+    // a tile has to be inside the poster, the coordinator never asks for anything else
+    const PosterTile &tile = settings.posterTile;
+    if(!settings.posterTilePath.empty() && (tile.x < 0 || tile.y < 0 || tile.width < 1 || tile.height < 1
+                                           || tile.x + tile.width > settings.posterWidth
+                                           || tile.y + tile.height > settings.posterHeight)){
+        std::cout << "ERROR: POSTER TILE IS OUTSIDE THE POSTER" << std::endl;
+        settings.posterTilePath.clear();
+    }
+
+    // only the point modes have points to count
+    if(settings.density && settings.mode != RenderMode::Points && settings.mode != RenderMode::GpuPoints){
+        std::cout << "WARNING: --density only works with point modes" << std::endl;
+        settings.density = false;
+    }
+
+    if(settings.view.zoom <= 0.0){
+        std::cout << "WARNING: zoom has to be positive" << std::endl;
+        settings.view.zoom = 1.0;
+    }
+
+    // level 15 is already 14 million triangles
+    if(settings.level < 0 || settings.level > 15){
+        std::cout << "WARNING: level has to be between 0 and 15" << std::endl;
+        settings.level = std::max(0, std::min(settings.level, 15));
+    }
+    return settings;
+}
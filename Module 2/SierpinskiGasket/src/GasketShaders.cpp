@@ -0,0 +1,438 @@
+#include "GasketShaders.h"
+
+#include <iostream>
+
+#include <glad/glad.h>
+
+const char *vertexShaderSource = "#version 330 core\n"
+    "layout (location = 0) in vec3 aPos;\n"
+    "void main()\n"
+    "{\n"
+    "   gl_Position = vec4(aPos.x, aPos.y, aPos.z, 1.0);\n"
+    "   gl_PointSize =   5.0;\n"
+    "}\0";
+
+const char *fragmentShaderSource = "#version 330 core\n"
+    "out vec4 FragColor;\n"
+    "void main()\n"
+    "{\n"
+    "    FragColor = vec4(0.21f, 0.0f, 0.25f, 1.0f);\n"
+    "}\0";
+
+// points packed down to (x, y), z is always zero and positionScale undoes any scaling done while packing
+const char *compactPointVertexSource = "#version 330 core\n"
+    "layout (location = 0) in vec2 aPos;\n"
+    "uniform float positionScale;\n"
+    "void main()\n"
+    "{\n"
+    "   gl_Position = vec4(aPos * positionScale, 0.0, 1.0);\n"
+    "   gl_PointSize =   5.0;\n"
+    "}\0";
+
+// cloud file points, panned and zoomed on the GPU. the streamer already thinned them to a few per pixel so they
+// are drawn a pixel big
+const char *cloudVertexSource = "#version 330 core\n"
+    "layout (location = 0) in vec2 aPos;\n"
+    "uniform float positionScale;\n"
+    "uniform vec2 viewCenter;\n"
+    "uniform float viewZoom;\n"
+    "void main()\n"
+    "{\n"
+    "   gl_Position = vec4((aPos * positionScale - viewCenter) * viewZoom, 0.0, 1.0);\n"
+    "   gl_PointSize = 1.0;\n"
+    "}\0";
+
+// integer hash shared by every shader that makes its own points (lowbias32)
+#define GASKET_HASH_GLSL \
+    "uint hash(uint x)\n" \
+    "{\n" \
+    "   x ^= x >> 16u; x *= 0x7feb352du;\n" \
+    "   x ^= x >> 15u; x *= 0x846ca68bu;\n" \
+    "   x ^= x >> 16u;\n" \
+    "   return x;\n" \
+    "}\n"
+
+// walks depth hashed vertex choices for point index, depth midpoint steps shrink the starting point's error
+// by 2^-depth so 24 is already below float precision
+#define GASKET_POINT_GLSL \
+    "const vec2 corners[3] = vec2[3](vec2(-0.5, -0.5), vec2(0.0, 0.5), vec2(0.5, -0.5));\n" \
+    GASKET_HASH_GLSL \
+    "vec2 gasketPoint(uint index, uint seed, int depth)\n" \
+    "{\n" \
+    "   uint state = hash(index ^ hash(seed));\n" \
+    "   vec2 point = vec2(0.0);\n" \
+    "   for(int i = 0; i < depth; i++){\n" \
+    "       state = state * 747796405u + 2891336453u;\n" \
+    "       uint vertex = ((state >> 16u) * 3u) >> 16u;\n" \
+    "       point = (point + corners[vertex]) * 0.5;\n" \
+    "   }\n" \
+    "   return point;\n" \
+    "}\n"
+
+// no vertex data at all, every point is built from gl_VertexID. base is where this draw starts
+// since one draw can't count past INT_MAX vertices
+const char *gpuPointVertexSource = "#version 330 core\n"
+    "uniform uint base;\n"
+    "uniform uint seed;\n"
+    "uniform int depth;\n"
+    GASKET_POINT_GLSL
+    "void main()\n"
+    "{\n"
+    "   gl_Position = vec4(gasketPoint(base + uint(gl_VertexID), seed, depth), 0.0, 1.0);\n"
+    "   gl_PointSize =   5.0;\n"
+    "}\0";
+
+// one triangle drawn 3^level times, the base 3 digits of gl_InstanceID pick which corner to shrink toward
+// at each level so every instance lands on its own level N subtriangle
+const char *instancedVertexSource = "#version 330 core\n"
+    "layout (location = 0) in vec3 aPos;\n"
+    "uniform int level;\n"
+    "const vec2 corners[3] = vec2[3](vec2(-0.5, -0.5), vec2(0.0, 0.5), vec2(0.5, -0.5));\n"
+    "void main()\n"
+    "{\n"
+    "   int id = gl_InstanceID;\n"
+    "   float scale = 1.0;\n"
+    "   vec2 offset = vec2(0.0);\n"
+    "   for(int i = 0; i < level; i++){\n"
+    "       int digit = id % 3;\n"
+    "       id /= 3;\n"
+    "       scale *= 0.5;\n"
+    "       offset = (offset + corners[digit]) * 0.5;\n"
+    "   }\n"
+    "   gl_Position = vec4(aPos.xy * scale + offset, aPos.z, 1.0);\n"
+    "}\0";
+
+// bins points into a per pixel counter instead of drawing them, points come from the vertex buffer
+// bound as a storage buffer or get generated right here when generate is set
+// the buffer is read as raw words so every PointFormat can be unpacked: 0 xyz, 1 xy, 2 half, 3 short
+const char *densityComputeSource = "#version 430 core\n"
+    "layout (local_size_x = 256) in;\n"
+    "layout (r32ui, binding = 0) uniform uimage2D density;\n"
+    "layout (std430, binding = 0) readonly buffer Points { uint words[]; };\n"
+    "layout (std430, binding = 1) coherent buffer Peak { uint maxDensity; };\n"
+    "uniform uint firstPoint;\n"
+    "uniform uint pointCount;\n"
+    "uniform bool generate;\n"
+    "uniform int pointFormat;\n"
+    "uniform float positionScale;\n"
+    "uniform uint seed;\n"
+    "uniform int depth;\n"
+    GASKET_POINT_GLSL
+    "vec2 loadPoint(uint index)\n"
+    "{\n"
+    "   if(pointFormat == 0) return uintBitsToFloat(uvec2(words[index * 3u], words[index * 3u + 1u]));\n"
+    "   if(pointFormat == 1) return uintBitsToFloat(uvec2(words[index * 2u], words[index * 2u + 1u]));\n"
+    "   if(pointFormat == 2) return unpackHalf2x16(words[index]);\n"
+    "   return unpackSnorm2x16(words[index]) * positionScale;\n"
+    "}\n"
+    "void main()\n"
+    "{\n"
+    "   uint offset = gl_GlobalInvocationID.x + gl_GlobalInvocationID.y * gl_NumWorkGroups.x * 256u;\n"
+    "   if(offset >= pointCount) return;\n"
+    "   uint index = firstPoint + offset;\n"
+    "   vec2 point = generate ? gasketPoint(index, seed, depth) : loadPoint(index);\n"
+    "   ivec2 size = imageSize(density);\n"
+    "   ivec2 pixel = ivec2((point * 0.5 + 0.5) * vec2(size));\n"
+    "   if(any(lessThan(pixel, ivec2(0))) || any(greaterThanEqual(pixel, size))) return;\n"
+    "   uint count = imageAtomicAdd(density, pixel, 1u) + 1u;\n"
+    "   if(count > maxDensity) atomicMax(maxDensity, count);\n" // the plain read skips most of the atomics
+    "}\0";
+
+// one triangle that covers the screen, positions come from gl_VertexID
+const char *fullscreenVertexSource = "#version 330 core\n"
+    "void main()\n"
+    "{\n"
+    "   vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"
+    "   gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);\n"
+    "}\0";
+
+// per pixel membership test, no geometry at all. the pixel is moved into the triangle's lattice coordinates
+// (u along the base, v up the left side) and folded one level at a time: doubling both and dropping the
+// integer part picks the corner subtriangle, landing in the middle (u + v > 1) means a hole
+// pan and zoom would run out of float bits around 10^7x, so the view center and every coordinate after it are
+// double-float pairs (hi, lo) and the additions are error free two sums that `precise` keeps the compiler from fusing
+const char *analyticFragmentSource = "#version 400 core\n"
+    "uniform vec2 centerHi;\n"
+    "uniform vec2 centerLo;\n"
+    "uniform vec2 pixelSize;\n"
+    "uniform vec2 screenCenter;\n"
+    "uniform int levels;\n"
+    "out vec4 FragColor;\n"
+    "vec2 twoSum(float a, float b)\n"
+    "{\n"
+    "   precise float sum = a + b;\n"
+    "   precise float bPart = sum - a;\n"
+    "   precise float error = (a - (sum - bPart)) + (b - bPart);\n"
+    "   return vec2(sum, error);\n"
+    "}\n"
+    "vec2 dfAdd(vec2 a, vec2 b)\n"
+    "{\n"
+    "   vec2 sum = twoSum(a.x, b.x);\n"
+    "   precise float low = sum.y + a.y + b.y;\n"
+    "   return twoSum(sum.x, low);\n"
+    "}\n"
+    "bool dfAtLeastOne(vec2 a)\n"
+    "{\n"
+    "   return a.x > 1.0 || (a.x == 1.0 && a.y >= 0.0);\n"
+    "}\n"
+    "bool dfAboveOne(vec2 a)\n"
+    "{\n"
+    "   return a.x > 1.0 || (a.x == 1.0 && a.y > 0.0);\n"
+    "}\n"
+    "void main()\n"
+    "{\n"
+    "   vec2 offset = (gl_FragCoord.xy - screenCenter) * pixelSize;\n"
+    "   vec2 x = dfAdd(vec2(centerHi.x, centerLo.x), vec2(offset.x, 0.0));\n"
+    "   vec2 y = dfAdd(vec2(centerHi.y, centerLo.y), vec2(offset.y, 0.0));\n"
+    // world to lattice: v = y + 0.5, u = x + 0.5 - v / 2 (halving is exact)
+    "   vec2 v = dfAdd(y, vec2(0.5, 0.0));\n"
+    "   vec2 u = dfAdd(dfAdd(x, vec2(0.5, 0.0)), -0.5 * v);\n"
+    "   bool inside = u.x >= 0.0 && v.x >= 0.0 && !dfAboveOne(dfAdd(u, v));\n"
+    "   for(int i = 0; i < levels && inside; i++){\n"
+    "       u *= 2.0;\n"
+    "       v *= 2.0;\n"
+    "       if(dfAtLeastOne(u)) u = dfAdd(u, vec2(-1.0, 0.0));\n"
+    "       else if(dfAtLeastOne(v)) v = dfAdd(v, vec2(-1.0, 0.0));\n"
+    "       inside = !dfAboveOne(dfAdd(u, v));\n"
+    "   }\n"
+    "   FragColor = inside ? vec4(0.21, 0.0, 0.25, 1.0) : vec4(0.0, 0.0, 0.0, 1.0);\n"
+    "}\0";
+
+// log density tone map, empty pixels stay black and the busiest pixel goes almost white
+const char *toneMapFragmentSource = "#version 430 core\n"
+    "layout (binding = 0) uniform usampler2D density;\n"
+    "layout (std430, binding = 1) readonly buffer Peak { uint maxDensity; };\n"
+    "out vec4 FragColor;\n"
+    "void main()\n"
+    "{\n"
+    "   uint count = texelFetch(density, ivec2(gl_FragCoord.xy), 0).r;\n"
+    "   float level = log(1.0 + float(count)) / log(1.0 + float(max(maxDensity, 1u)));\n"
+    "   vec3 color = mix(vec3(0.0), vec3(0.21, 0.0, 0.25), clamp(level * 2.0, 0.0, 1.0));\n"
+    "   color = mix(color, vec3(1.0, 0.85, 1.0), clamp(level * 2.0 - 1.0, 0.0, 1.0));\n"
+    "   FragColor = vec4(color, 1.0);\n"
+    "}\0";
+
+// pinhole camera shared by both raymarch passes, viewScale is (tan(fov / 2) * aspect, tan(fov / 2))
+#define RAYMARCH_CAMERA_GLSL \
+    "uniform vec3 cameraPosition;\n" \
+    "uniform vec3 cameraRight;\n" \
+    "uniform vec3 cameraUp;\n" \
+    "uniform vec3 cameraForward;\n" \
+    "uniform vec2 viewScale;\n" \
+    "uniform vec2 resolution;\n" \
+    "vec3 rayDirection(vec2 pixel)\n" \
+    "{\n" \
+    "   vec2 ndc = (pixel / resolution) * 2.0 - 1.0;\n" \
+    "   return normalize(cameraForward + cameraRight * (ndc.x * viewScale.x) + cameraUp * (ndc.y * viewScale.y));\n" \
+    "}\n"
+
+// marches one ray per 2x2 block of the screen, sampleOffset picks the pixel in the block (plus a sub pixel jitter)
+// the distance estimate folds space into the corner sub tetrahedron levels times, each fold is a mirror across
+// one of the planes between two corners, so the cost is the same for any depth while geometry would be 4^levels
+// output is the lit color and the hit distance, -1 for rays that miss
+const char *raymarchTraceSource = "#version 330 core\n"
+    RAYMARCH_CAMERA_GLSL
+    "uniform vec2 sampleOffset;\n"
+    "uniform int levels;\n"
+    "out vec4 FragColor;\n"
+    "const int MAX_STEPS = 200;\n"
+    "const float BOUNDS = 1.75;\n" // sphere around the corners (±1, ±1, ±1)
+    "float tetrahedronDistance(vec3 p)\n"
+    "{\n"
+    "   return (max(max(-p.x - p.y - p.z, p.x + p.y - p.z), max(-p.x + p.y + p.z, p.x - p.y + p.z)) - 1.0) * 0.57735027;\n"
+    "}\n"
+    "float sierpinskiDistance(vec3 p)\n"
+    "{\n"
+    "   float scale = 1.0;\n"
+    "   for(int i = 0; i < levels; i++){\n"
+    "       if(p.x + p.y < 0.0) p.xy = -p.yx;\n"
+    "       if(p.x + p.z < 0.0) p.xz = -p.zx;\n"
+    "       if(p.y + p.z < 0.0) p.zy = -p.yz;\n"
+    "       p = p * 2.0 - vec3(1.0);\n"
+    "       scale *= 0.5;\n"
+    "   }\n"
+    "   return tetrahedronDistance(p) * scale;\n"
+    "}\n"
+    "void main()\n"
+    "{\n"
+    "   vec2 pixel = floor(gl_FragCoord.xy) * 2.0 + sampleOffset;\n"
+    "   vec3 direction = rayDirection(pixel);\n"
+    // only march inside the bounding sphere
+    "   float b = dot(cameraPosition, direction);\n"
+    "   float c = dot(cameraPosition, cameraPosition) - BOUNDS * BOUNDS;\n"
+    "   float disc = b * b - c;\n"
+    "   if(disc < 0.0){ FragColor = vec4(0.0, 0.0, 0.0, -1.0); return; }\n"
+    "   float t = max(0.0, -b - sqrt(disc));\n"
+    "   float far = -b + sqrt(disc);\n"
+    // close enough once the step is under half a pixel at this distance
+    "   float pixelAngle = 2.0 * viewScale.y / resolution.y;\n"
+    "   int steps = 0;\n"
+    "   bool hit = false;\n"
+    "   for(; steps < MAX_STEPS && t < far; steps++){\n"
+    "       float distance = sierpinskiDistance(cameraPosition + direction * t);\n"
+    "       if(distance < max(t, 1e-4) * pixelAngle * 0.5){ hit = true; break; }\n"
+    "       t += distance;\n"
+    "   }\n"
+    "   if(!hit){ FragColor = vec4(0.0, 0.0, 0.0, -1.0); return; }\n"
+    // normal from four taps on a tetrahedron, the step count stands in for ambient occlusion
+    "   vec3 p = cameraPosition + direction * t;\n"
+    "   float h = max(t, 1e-4) * pixelAngle;\n"
+    "   vec2 k = vec2(1.0, -1.0);\n"
+    "   vec3 normal = normalize(k.xyy * sierpinskiDistance(p + k.xyy * h) + k.yyx * sierpinskiDistance(p + k.yyx * h)\n"
+    "                         + k.yxy * sierpinskiDistance(p + k.yxy * h) + k.xxx * sierpinskiDistance(p + k.xxx * h));\n"
+    // key light from above plus a dimmer one from the camera so faces turned away from the key don't go black
+    "   float diffuse = 0.7 * max(dot(normal, normalize(vec3(-0.5, 0.8, 0.3))), 0.0) + 0.3 * max(dot(normal, -direction), 0.0);\n"
+    "   float occlusion = 1.0 - float(steps) / float(MAX_STEPS);\n"
+    "   vec3 color = vec3(0.42, 0.0, 0.5) * (0.3 + diffuse) * occlusion;\n"
+    "   FragColor = vec4(color, t);\n"
+    "}\0";
+
+// builds the full screen image from this frame's quarter of the rays and the last frame's image
+// every pixel works out where its surface was last frame and takes the history there if the depth agrees,
+// traced pixels blend their new sample in (a running average, capped so it keeps up with changes)
+// and untraced pixels just keep the history. without usable history the block's fresh ray fills in
+const char *raymarchResolveSource = "#version 330 core\n"
+    RAYMARCH_CAMERA_GLSL
+    "uniform sampler2D current;\n"
+    "uniform sampler2D historyColor;\n"
+    "uniform sampler2D historyDepth;\n"
+    "uniform ivec2 tracedPixel;\n"
+    "uniform bool historyValid;\n"
+    "uniform vec3 previousPosition;\n"
+    "uniform vec3 previousRight;\n"
+    "uniform vec3 previousUp;\n"
+    "uniform vec3 previousForward;\n"
+    "layout (location = 0) out vec4 outColor;\n"
+    "layout (location = 1) out float outDepth;\n"
+    "const float MAX_HISTORY = 16.0;\n"
+    "bool reproject(vec3 direction, float t, out vec4 history)\n"
+    "{\n"
+    // misses are points at infinity, only the direction matters
+    "   vec3 relative = (t > 0.0) ? cameraPosition + direction * t - previousPosition : direction;\n"
+    "   float z = dot(relative, previousForward);\n"
+    "   if(z <= 0.0) return false;\n"
+    "   vec2 ndc = vec2(dot(relative, previousRight), dot(relative, previousUp)) / (z * viewScale);\n"
+    "   vec2 pixel = (ndc * 0.5 + 0.5) * resolution;\n"
+    "   if(any(lessThan(pixel, vec2(0.0))) || any(greaterThanEqual(pixel, resolution))) return false;\n"
+    "   float historyT = texelFetch(historyDepth, ivec2(pixel), 0).r;\n"
+    "   if(t > 0.0){\n"
+    "       float expected = length(relative);\n"
+    "       if(historyT <= 0.0 || abs(historyT - expected) > 0.02 * expected) return false;\n"
+    "   } else if(historyT > 0.0){\n"
+    "       return false;\n"
+    "   }\n"
+    "   history = texture(historyColor, pixel / resolution);\n"
+    "   return true;\n"
+    "}\n"
+    "void main()\n"
+    "{\n"
+    "   ivec2 pixel = ivec2(gl_FragCoord.xy);\n"
+    "   vec4 fresh = texelFetch(current, pixel / 2, 0);\n"
+    "   bool traced = all(equal(pixel & 1, tracedPixel));\n"
+    "   vec3 direction = rayDirection(vec2(pixel) + 0.5);\n"
+    "   float t = fresh.a;\n"
+    "   vec4 history = vec4(0.0);\n"
+    "   bool found = historyValid && reproject(direction, t, history);\n"
+    // on edges the block's depth is wrong for the other three pixels, their own surface from last frame usually isn't
+    // (a miss there proves nothing, it would just paint the background over whatever the block hit)
+    "   float ownT = texelFetch(historyDepth, pixel, 0).r;\n"
+    "   if(historyValid && !found && ownT > 0.0){\n"
+    "       found = reproject(direction, ownT, history);\n"
+    "       if(found && !traced) t = ownT;\n"
+    "   }\n"
+    "   vec3 color = fresh.rgb;\n"
+    "   float count = 1.0;\n"
+    "   if(found && traced){\n"
+    "       count = min(history.a + 1.0, MAX_HISTORY);\n"
+    "       color = mix(history.rgb, fresh.rgb, 1.0 / count);\n"
+    "   } else if(found){\n"
+    "       count = history.a;\n"
+    "       color = history.rgb;\n"
+    "   }\n"
+    "   outColor = vec4(color, count);\n"
+    "   outDepth = t;\n"
+    "}\0";
+
+unsigned int compileProgram(const char *vertexSource, const char *fragmentSource){
+    // create our vertex shader object
+    unsigned int vertexShader; // this is the ID of the vertex shader
+    vertexShader = glCreateShader(GL_VERTEX_SHADER);
+
+    // Attach source code to vertex shader and compile shader
+    glShaderSource(vertexShader, 1, &vertexSource, NULL);
+    glCompileShader(vertexShader);
+
+    // Status check on our vertex Shader compiler
+    int  success; // success code
+    char infoLog[512]; // error log buffer
+    
+    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success); // actual code to check shader
+    if(!success){
+        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
+        std::cout << "ERROR: VERTEX SHADER COMPILATION FAILED\n" << infoLog << std::endl;
+    }
+
+
+    // create our fragment shader object
+    unsigned int fragmentShader;
+    fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fragmentShader, 1, &fragmentSource, NULL);
+    glCompileShader(fragmentShader);
+
+    // sanity check on fragment shader
+    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success); // actual code to check shader
+    if(!success){
+        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
+        std::cout << "ERROR: FRAGMENT SHADER COMPILATION FAILED\n" << infoLog << std::endl;
+    }
+    // now that we have shaders. it is time to combine them into a program and link them
+    // create shader program
+    unsigned int shaderProgram;
+    shaderProgram = glCreateProgram();
+
+    // attach and link vertex and fragment shaders. ORDER MATTERS!!!!
+    glAttachShader(shaderProgram, vertexShader);
+    glAttachShader(shaderProgram, fragmentShader);
+    glLinkProgram(shaderProgram);
+
+    // sanity check on shader program
+    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
+    if(!success) {
+        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
+        std::cout << "ERROR: SHADER PROGRAM FAILED\n" << infoLog << std::endl;
+    }
+
+    // shaders are linked and attached so we can delete them now
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);  
+
+    return shaderProgram;
+}
+
+unsigned int compileComputeProgram(const char *computeSource){
+    int  success; // success code
+    char infoLog[512]; // error log buffer
+
+    unsigned int computeShader = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(computeShader, 1, &computeSource, NULL);
+    glCompileShader(computeShader);
+
+    glGetShaderiv(computeShader, GL_COMPILE_STATUS, &success);
+    if(!success){
+        glGetShaderInfoLog(computeShader, 512, NULL, infoLog);
+        std::cout << "ERROR: COMPUTE SHADER COMPILATION FAILED\n" << infoLog << std::endl;
+    }
+
+    unsigned int computeProgram = glCreateProgram();
+    glAttachShader(computeProgram, computeShader);
+    glLinkProgram(computeProgram);
+
+    glGetProgramiv(computeProgram, GL_LINK_STATUS, &success);
+    if(!success) {
+        glGetProgramInfoLog(computeProgram, 512, NULL, infoLog);
+        std::cout << "ERROR: COMPUTE PROGRAM FAILED\n" << infoLog << std::endl;
+    }
+
+    glDeleteShader(computeShader);
+    return computeProgram;
+}
@@ -0,0 +1,126 @@
+#include "MortonOrder.h"
+
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// below this a single thread sorts faster than starting the others
+static const long long MIN_POINTS_PER_THREAD = 1 << 16;
+
+// one byte of the key per pass
+static const int RADIX_BITS = 8;
+static const int BUCKETS = 1 << RADIX_BITS;
+
+// the key travels with its point so every pass is one streaming read and one scattered write
+struct MortonPoint {
+    uint32_t key;
+    float x, y, z;
+};
+
+// spreads the low 16 bits out to the even bits
+static uint32_t spreadBits(uint32_t value){
+    value &= 0xffffu;
+    value = (value | (value << 8)) & 0x00ff00ffu;
+    value = (value | (value << 4)) & 0x0f0f0f0fu;
+    value = (value | (value << 2)) & 0x33333333u;
+    value = (value | (value << 1)) & 0x55555555u;
+    return value;
+}
+
+static uint32_t quantize(float value){
+    float scaled = (value + 0.5f) * 65536.0f;
+    return static_cast<uint32_t>(std::max(0.0f, std::min(scaled, 65535.0f)));
+}
+
+uint32_t mortonKey(float x, float y){
+    return spreadBits(quantize(x)) | (spreadBits(quantize(y)) << 1);
+}
+
+// runs work(first, last, thread) over contiguous ranges, one per thread
+template <typename Work>
+static void forEachChunk(long long count, unsigned int threadCount, Work work){
+    long long chunkSize = (count + threadCount - 1) / threadCount;
+    std::vector<std::thread> workers;
+    for(unsigned int t = 1; t < threadCount; t++){
+        long long first = std::min(count, t * chunkSize);
+        workers.emplace_back(work, first, std::min(count, first + chunkSize), t);
+    }
+    work(0, std::min(count, chunkSize), 0u);
+    for(std::thread &worker : workers){
+        worker.join();
+    }
+}
+
+void sortPointsMorton(float points[], long long count, unsigned int threadCount){
+    if(threadCount == 0){
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threadCount = static_cast<unsigned int>(std::max(1LL, std::min<long long>(threadCount, count / MIN_POINTS_PER_THREAD)));
+    if(count < 2){
+        return;
+    }
+
+    // left uninitialized, zeroing 32 bytes a point up front costs about as much as a pass
+    std::unique_ptr<MortonPoint[]> current(new MortonPoint[count]);
+    std::unique_ptr<MortonPoint[]> sorted(new MortonPoint[count]);
+    forEachChunk(count, threadCount, [&](long long first, long long last, unsigned int){
+        for(long long i = first; i < last; i++){
+            const float *point = points + i * 3;
+            current[i] = { mortonKey(point[0], point[1]), point[0], point[1], point[2] };
+        }
+    });
+
+    // histograms[thread][bucket], the chunks never change between passes so each thread owns its row
+    std::vector<long long> histograms(static_cast<size_t>(threadCount) * BUCKETS);
+    for(int shift = 0; shift < 32; shift += RADIX_BITS){
+        std::fill(histograms.begin(), histograms.end(), 0);
+        forEachChunk(count, threadCount, [&](long long first, long long last, unsigned int t){
+            long long *histogram = &histograms[static_cast<size_t>(t) * BUCKETS];
+            for(long long i = first; i < last; i++){
+                histogram[(current[i].key >> shift) & (BUCKETS - 1)]++;
+            }
+        });
+
+        // a byte every point shares moves nothing, the high bytes are often like that on small attractors
+        bool allSame = false;
+        for(int bucket = 0; bucket < BUCKETS; bucket++){
+            long long total = 0;
+            for(unsigned int t = 0; t < threadCount; t++){
+                total += histograms[static_cast<size_t>(t) * BUCKETS + bucket];
+            }
+            allSame = allSame || total == count;
+        }
+        if(allSame){
+            continue;
+        }
+
+        // bucket major then thread, so thread t writes its share of a bucket right after thread t - 1 and order is kept
+        long long offset = 0;
+        for(int bucket = 0; bucket < BUCKETS; bucket++){
+            for(unsigned int t = 0; t < threadCount; t++){
+                long long &slot = histograms[static_cast<size_t>(t) * BUCKETS + bucket];
+                long long size = slot;
+                slot = offset;
+                offset += size;
+            }
+        }
+
+        forEachChunk(count, threadCount, [&](long long first, long long last, unsigned int t){
+            long long *next = &histograms[static_cast<size_t>(t) * BUCKETS];
+            for(long long i = first; i < last; i++){
+                sorted[next[(current[i].key >> shift) & (BUCKETS - 1)]++] = current[i];
+            }
+        });
+        current.swap(sorted);
+    }
+
+    forEachChunk(count, threadCount, [&](long long first, long long last, unsigned int){
+        for(long long i = first; i < last; i++){
+            float *point = points + i * 3;
+            point[0] = current[i].x;
+            point[1] = current[i].y;
+            point[2] = current[i].z;
+        }
+    });
+}
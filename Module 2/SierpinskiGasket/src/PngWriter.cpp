@@ -0,0 +1,138 @@
+#include "PngWriter.h"
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+
+// biggest payload a stored deflate block can hold
+static const size_t MAX_STORED_BLOCK = 65535;
+
+static constexpr std::array<uint32_t, 256> buildCrcTable(){
+    std::array<uint32_t, 256> table{};
+    for(uint32_t n = 0; n < 256; n++){
+        uint32_t c = n;
+        for(int k = 0; k < 8; k++){
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        table[n] = c;
+    }
+    return table;
+}
+
+static constexpr std::array<uint32_t, 256> CRC_TABLE = buildCrcTable();
+
+static uint32_t crc32(uint32_t crc, const unsigned char data[], size_t length){
+    crc = ~crc;
+    for(size_t i = 0; i < length; i++){
+        crc = CRC_TABLE[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static uint32_t adler32(uint32_t adler, const unsigned char data[], size_t length){
+    uint32_t a = adler & 0xFFFF;
+    uint32_t b = adler >> 16;
+    // 5552 bytes is the most that can be summed before b has to be reduced
+    while(length > 0){
+        size_t run = std::min<size_t>(length, 5552);
+        for(size_t i = 0; i < run; i++){
+            a += data[i];
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+        data += run;
+        length -= run;
+    }
+    return (b << 16) | a;
+}
+
+static void appendBigEndian(std::string &out, uint32_t value){
+    out.push_back(static_cast<char>(value >> 24));
+    out.push_back(static_cast<char>(value >> 16));
+    out.push_back(static_cast<char>(value >> 8));
+    out.push_back(static_cast<char>(value));
+}
+
+PngWriter::PngWriter() : width(0), height(0), rowsWritten(0), adler(1){}
+
+void PngWriter::writeChunk(const char type[4], const std::string &data){
+    std::string header;
+    appendBigEndian(header, static_cast<uint32_t>(data.size()));
+    header.append(type, 4);
+    uint32_t crc = crc32(0, reinterpret_cast<const unsigned char*>(type), 4);
+    crc = crc32(crc, reinterpret_cast<const unsigned char*>(data.data()), data.size());
+
+    std::string footer;
+    appendBigEndian(footer, crc);
+    file.write(header.data(), header.size());
+    file.write(data.data(), data.size());
+    file.write(footer.data(), footer.size());
+}
+
+bool PngWriter::open(const std::string &path, int width, int height){
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if(!file){
+        std::cout << "ERROR: COULD NOT CREATE IMAGE " << path << std::endl;
+        return false;
+    }
+    this->width = width;
+    this->height = height;
+    rowsWritten = 0;
+    adler = 1;
+
+    file.write("\x89PNG\r\n\x1a\n", 8);
+
+    // 8 bits per channel, RGB, no interlacing
+    std::string header;
+    appendBigEndian(header, static_cast<uint32_t>(width));
+    appendBigEndian(header, static_cast<uint32_t>(height));
+    header.append("\x08\x02\x00\x00\x00", 5);
+    writeChunk("IHDR", header);
+
+    // zlib header, deflate with the smallest window since nothing ever looks back
+    writeChunk("IDAT", std::string("\x78\x01", 2));
+    return static_cast<bool>(file);
+}
+
+void PngWriter::writeRow(const unsigned char rgb[]){
+    // every row starts with its filter type, 0 is none
+    size_t rowSize = static_cast<size_t>(width) * 3;
+    const unsigned char filter = 0;
+    adler = adler32(adler, &filter, 1);
+    adler = adler32(adler, rgb, rowSize);
+
+    // one IDAT per row, the deflate stream just carries on across them
+    chunkData.clear();
+    size_t total = rowSize + 1;
+    for(size_t written = 0; written < total; ){
+        size_t block = std::min(total - written, MAX_STORED_BLOCK);
+        chunkData.push_back('\x00'); // not final, stored
+        chunkData.push_back(static_cast<char>(block & 0xFF));
+        chunkData.push_back(static_cast<char>(block >> 8));
+        chunkData.push_back(static_cast<char>(~block & 0xFF));
+        chunkData.push_back(static_cast<char>((~block >> 8) & 0xFF));
+        for(size_t i = written; i < written + block; i++){
+            chunkData.push_back((i == 0) ? static_cast<char>(filter) : static_cast<char>(rgb[i - 1]));
+        }
+        written += block;
+    }
+    writeChunk("IDAT", chunkData);
+    rowsWritten++;
+}
+
+bool PngWriter::close(){
+    if(rowsWritten != height){
+        std::cout << "ERROR: IMAGE GOT " << rowsWritten << " OF " << height << " ROWS" << std::endl;
+    }
+
+    // empty final block, then the checksum of the whole uncompressed stream
+    std::string tail("\x01\x00\x00\xFF\xFF", 5);
+    appendBigEndian(tail, adler);
+    writeChunk("IDAT", tail);
+    writeChunk("IEND", std::string());
+
+    bool written = static_cast<bool>(file) && rowsWritten == height;
+    file.close();
+    return written;
+}
@@ -0,0 +1,331 @@
+#include "PointCloudFile.h"
+#include "ChaosGame.h"
+#include "MortonOrder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// points generated per block while building, the only part of the cloud that is ever in memory
+static const long long BLOCK_POINTS = 1 << 22;
+
+static const char CLOUD_MAGIC[8] = { 'G', 'A', 'S', 'K', 'E', 'T', 'Q', 'T' };
+
+MappedFile::MappedFile() : bytes(nullptr), length(0),
+#ifdef _WIN32
+    fileHandle(INVALID_HANDLE_VALUE), mappingHandle(nullptr){
+#else
+    descriptor(-1){
+#endif
+}
+
+MappedFile::~MappedFile(){
+    close();
+}
+
+#ifdef _WIN32
+static bool mapWindowsFile(void *fileHandle, size_t size, bool writable, void *&mappingHandle, unsigned char *&bytes){
+    DWORD protect = writable ? PAGE_READWRITE : PAGE_READONLY;
+    mappingHandle = CreateFileMappingA(fileHandle, NULL, protect, static_cast<DWORD>(static_cast<uint64_t>(size) >> 32),
+                                       static_cast<DWORD>(size & 0xffffffffu), NULL);
+    if(!mappingHandle){
+        return false;
+    }
+    bytes = static_cast<unsigned char*>(MapViewOfFile(mappingHandle, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size));
+    return bytes != nullptr;
+}
+
+bool MappedFile::openRead(const std::string &path){
+    close();
+    fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    LARGE_INTEGER fileSize;
+    if(fileHandle == INVALID_HANDLE_VALUE || !GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0){
+        close();
+        return false;
+    }
+    length = static_cast<size_t>(fileSize.QuadPart);
+    if(!mapWindowsFile(fileHandle, length, false, mappingHandle, bytes)){
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool MappedFile::create(const std::string &path, size_t size){
+    close();
+    fileHandle = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(fileHandle == INVALID_HANDLE_VALUE){
+        close();
+        return false;
+    }
+    // creating the mapping at the full size is what grows the file
+    length = size;
+    if(!mapWindowsFile(fileHandle, length, true, mappingHandle, bytes)){
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::flush(){
+    if(bytes){
+        FlushViewOfFile(bytes, length);
+        FlushFileBuffers(fileHandle);
+    }
+}
+
+void MappedFile::close(){
+    if(bytes){
+        UnmapViewOfFile(bytes);
+    }
+    if(mappingHandle){
+        CloseHandle(mappingHandle);
+    }
+    if(fileHandle != INVALID_HANDLE_VALUE){
+        CloseHandle(fileHandle);
+    }
+    bytes = nullptr;
+    mappingHandle = nullptr;
+    fileHandle = INVALID_HANDLE_VALUE;
+    length = 0;
+}
+#else
+bool MappedFile::openRead(const std::string &path){
+    close();
+    descriptor = ::open(path.c_str(), O_RDONLY);
+    struct stat status;
+    if(descriptor < 0 || fstat(descriptor, &status) != 0 || status.st_size == 0){
+        close();
+        return false;
+    }
+    length = static_cast<size_t>(status.st_size);
+    void *mapped = mmap(nullptr, length, PROT_READ, MAP_SHARED, descriptor, 0);
+    if(mapped == MAP_FAILED){
+        close();
+        return false;
+    }
+    bytes = static_cast<unsigned char*>(mapped);
+    return true;
+}
+
+bool MappedFile::create(const std::string &path, size_t size){
+    close();
+    descriptor = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(descriptor < 0 || ftruncate(descriptor, static_cast<off_t>(size)) != 0){
+        close();
+        return false;
+    }
+    length = size;
+    void *mapped = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    if(mapped == MAP_FAILED){
+        close();
+        return false;
+    }
+    bytes = static_cast<unsigned char*>(mapped);
+    return true;
+}
+
+void MappedFile::flush(){
+    if(bytes){
+        msync(bytes, length, MS_SYNC);
+    }
+}
+
+void MappedFile::close(){
+    if(bytes){
+        munmap(bytes, length);
+    }
+    if(descriptor >= 0){
+        ::close(descriptor);
+    }
+    bytes = nullptr;
+    descriptor = -1;
+    length = 0;
+}
+#endif
+
+unsigned char *MappedFile::data() const{
+    return bytes;
+}
+
+size_t MappedFile::size() const{
+    return length;
+}
+
+PointCloudFile::PointCloudFile() : header(nullptr), leafOffsets(nullptr), pointData(nullptr){
+}
+
+bool PointCloudFile::open(const std::string &path){
+    close();
+    if(!file.openRead(path)){
+        std::cout << "ERROR: COULD NOT MAP CLOUD FILE " << path << std::endl;
+        return false;
+    }
+
+    header = reinterpret_cast<const CloudHeader*>(file.data());
+    bool valid = file.size() >= sizeof(CloudHeader) && std::memcmp(header->magic, CLOUD_MAGIC, sizeof(CLOUD_MAGIC)) == 0
+                 && header->version == CLOUD_VERSION && header->depth >= 1 && header->depth <= MAX_CLOUD_DEPTH
+                 && header->format <= static_cast<uint32_t>(PointFormat::Short2)
+                 && header->fractal <= static_cast<uint32_t>(FractalType::Tetrahedron);
+    if(valid){
+        size_t indexSize = (static_cast<size_t>(leafCount()) + 1) * sizeof(uint64_t);
+        size_t pointsSize = static_cast<size_t>(header->pointCount) * pointFormatStride(format());
+        valid = file.size() == sizeof(CloudHeader) + indexSize + pointsSize;
+    }
+    if(!valid){
+        std::cout << "ERROR: " << path << " IS NOT A CLOUD FILE THIS VIEWER CAN READ" << std::endl;
+        close();
+        return false;
+    }
+
+    leafOffsets = reinterpret_cast<const uint64_t*>(file.data() + sizeof(CloudHeader));
+    pointData = file.data() + sizeof(CloudHeader) + (leafCount() + 1) * sizeof(uint64_t);
+    return true;
+}
+
+void PointCloudFile::close(){
+    file.close();
+    header = nullptr;
+    leafOffsets = nullptr;
+    pointData = nullptr;
+}
+
+bool PointCloudFile::isOpen() const{
+    return header != nullptr;
+}
+
+int PointCloudFile::depth() const{
+    return static_cast<int>(header->depth);
+}
+
+FractalType PointCloudFile::fractal() const{
+    return static_cast<FractalType>(header->fractal);
+}
+
+long long PointCloudFile::pointCount() const{
+    return static_cast<long long>(header->pointCount);
+}
+
+long long PointCloudFile::leafCount() const{
+    return 1LL << (2 * header->depth);
+}
+
+PointFormat PointCloudFile::format() const{
+    return static_cast<PointFormat>(header->format);
+}
+
+long long PointCloudFile::leafBegin(long long leaf) const{
+    return static_cast<long long>(leafOffsets[leaf]);
+}
+
+const unsigned char *PointCloudFile::point(long long index) const{
+    return pointData + index * pointFormatStride(format());
+}
+
+// points [first, first + count) of the cloud as (x, y, z), each block gets its own seed so blocks can be remade alone
+static void generateBlock(FractalType fractal, long long first, long long count, std::vector<float> &points,
+                          unsigned int threadCount, uint64_t seed, ChaosKernel kernel){
+    uint64_t blockSeed = seed + static_cast<uint64_t>(first / BLOCK_POINTS) * 0x9E3779B97F4A7C15ULL;
+    std::vector<float> generated(fractalFloatCount(fractal, count));
+    constructFractal(fractal, count, generated.data(), threadCount, blockSeed, kernel);
+
+    // the gasket puts its bounding triangle in front, the cloud only wants the points
+    size_t skip = generated.size() - static_cast<size_t>(count) * 3;
+    points.assign(generated.begin() + skip, generated.end());
+}
+
+bool pointCloudNeedsBuild(const std::string &path){
+    MappedFile file;
+    if(!file.openRead(path)){
+        return true;
+    }
+    // the file is made full size and zeroed before anything goes in, so no magic means the build stopped part way
+    static const char NO_MAGIC[sizeof(CLOUD_MAGIC)] = {};
+    if(file.size() >= sizeof(CloudHeader) && std::memcmp(file.data(), NO_MAGIC, sizeof(NO_MAGIC)) == 0){
+        std::cout << "WARNING: " << path << " WAS NEVER FINISHED, BUILDING IT AGAIN" << std::endl;
+        return true;
+    }
+    return false;
+}
+
+bool buildPointCloud(const std::string &path, FractalType fractal, long long pointCount, int depth, PointFormat format,
+                     unsigned int threadCount, uint64_t seed, ChaosKernel kernel){
+    auto buildStart = std::chrono::steady_clock::now();
+    depth = std::max(1, std::min(depth, MAX_CLOUD_DEPTH));
+    long long leafCount = 1LL << (2 * depth);
+    int leafShift = 32 - (2 * depth);
+    size_t stride = pointFormatStride(format);
+
+    // first pass only counts how many points land in each leaf
+    std::vector<uint64_t> offsets(leafCount + 1, 0);
+    std::vector<float> points;
+    for(long long first = 0; first < pointCount; first += BLOCK_POINTS){
+        long long count = std::min(BLOCK_POINTS, pointCount - first);
+        generateBlock(fractal, first, count, points, threadCount, seed, kernel);
+        for(long long i = 0; i < count; i++){
+            offsets[(mortonKey(points[(i * 3)], points[(i * 3) + 1]) >> leafShift) + 1]++;
+        }
+    }
+    for(long long leaf = 0; leaf < leafCount; leaf++){
+        offsets[leaf + 1] += offsets[leaf];
+    }
+
+    size_t indexSize = offsets.size() * sizeof(uint64_t);
+    MappedFile file;
+    if(!file.create(path, sizeof(CloudHeader) + indexSize + static_cast<size_t>(pointCount) * stride)){
+        std::cout << "ERROR: COULD NOT CREATE CLOUD FILE " << path << std::endl;
+        return false;
+    }
+
+    // the header stays zeroed until the end, see pointCloudNeedsBuild
+    std::memcpy(file.data() + sizeof(CloudHeader), offsets.data(), indexSize);
+    unsigned char *pointData = file.data() + sizeof(CloudHeader) + indexSize;
+
+    // second pass makes the same blocks again and drops every point at the end of its leaf
+    std::vector<uint64_t> cursor(offsets.begin(), offsets.end() - 1);
+    std::vector<uint32_t> leaves;
+    for(long long first = 0; first < pointCount; first += BLOCK_POINTS){
+        long long count = std::min(BLOCK_POINTS, pointCount - first);
+        generateBlock(fractal, first, count, points, threadCount, seed, kernel);
+
+        leaves.resize(count);
+        for(long long i = 0; i < count; i++){
+            leaves[i] = mortonKey(points[(i * 3)], points[(i * 3) + 1]) >> leafShift;
+        }
+        packPoints(format, points.data(), count, points.data());
+        const unsigned char *packed = reinterpret_cast<const unsigned char*>(points.data());
+        for(long long i = 0; i < count; i++){
+            std::memcpy(pointData + cursor[leaves[i]]++ * stride, packed + i * stride, stride);
+        }
+    }
+
+    // only once the index and points are on disk does the header make it a cloud file
+    file.flush();
+    CloudHeader header = {};
+    std::memcpy(header.magic, CLOUD_MAGIC, sizeof(CLOUD_MAGIC));
+    header.version = CLOUD_VERSION;
+    header.depth = static_cast<uint32_t>(depth);
+    header.pointCount = static_cast<uint64_t>(pointCount);
+    header.format = static_cast<uint32_t>(format);
+    header.fractal = static_cast<uint32_t>(fractal);
+    std::memcpy(file.data(), &header, sizeof(header));
+    file.close();
+
+    auto buildTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart);
+    std::cout << "Wrote " << pointCount << " " << fractalName(fractal) << " points to " << path << " in "
+              << buildTime.count() << " ms" << std::endl;
+    return true;
+}
@@ -0,0 +1,128 @@
+#include "PointFormat.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <glad/glad.h>
+
+size_t pointFormatStride(PointFormat format){
+    switch(format){
+        case PointFormat::Float2:
+            return 2 * sizeof(float);
+        case PointFormat::Half2:
+        case PointFormat::Short2:
+            return 2 * sizeof(uint16_t);
+        default:
+            return 3 * sizeof(float);
+    }
+}
+
+const char *pointFormatName(PointFormat format){
+    switch(format){
+        case PointFormat::Float2:
+            return "xy";
+        case PointFormat::Half2:
+            return "half";
+        case PointFormat::Short2:
+            return "short";
+        default:
+            return "xyz";
+    }
+}
+
+float pointFormatScale(PointFormat format){
+    return (format == PointFormat::Short2) ? 0.5f : 1.0f;
+}
+
+uint16_t floatToHalf(float value){
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000u;
+    uint32_t magnitude = bits & 0x7fffffffu;
+
+    // infinity stays infinity and nan stays a (quiet) nan
+    if(magnitude >= 0x7f800000u){
+        return static_cast<uint16_t>(sign | 0x7c00u | ((magnitude > 0x7f800000u) ? 0x200u : 0u));
+    }
+    // 65520 and up rounds past the largest half
+    if(magnitude >= 0x477ff000u){
+        return static_cast<uint16_t>(sign | 0x7c00u);
+    }
+
+    // under 2^-14 the half is subnormal, counted in steps of 2^-24
+    if(magnitude < 0x38800000u){
+        if(magnitude < 0x33000000u){
+            return static_cast<uint16_t>(sign); // under half a step rounds to zero
+        }
+        uint32_t mantissa = (magnitude & 0x7fffffu) | 0x800000u;
+        uint32_t shift = 126 - (magnitude >> 23);
+        uint32_t half = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if(rest > halfway || (rest == halfway && (half & 1u))){
+            half++; // carrying into the exponent gives the smallest normal, which is right
+        }
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    // normal numbers just move the exponent bias from 127 to 15 and drop 13 mantissa bits
+    uint32_t half = (magnitude - 0x38000000u) >> 13;
+    uint32_t rest = magnitude & 0x1fffu;
+    if(rest > 0x1000u || (rest == 0x1000u && (half & 1u))){
+        half++;
+    }
+    return static_cast<uint16_t>(sign | half);
+}
+
+static int16_t floatToSnorm16(float value){
+    float clamped = std::max(-1.0f, std::min(value, 1.0f));
+    return static_cast<int16_t>(std::lrint(clamped * 32767.0f));
+}
+
+void packPoints(PointFormat format, const float points[], long long count, void *out){
+    unsigned char *bytes = static_cast<unsigned char*>(out);
+
+    if(format == PointFormat::Float3){
+        std::memmove(bytes, points, static_cast<size_t>(count) * 3 * sizeof(float));
+        return;
+    }
+
+    size_t stride = pointFormatStride(format);
+    for(long long i = 0; i < count; i++){
+        // read before writing, the packed point can overlap this point's own floats
+        float x = points[(i * 3)];
+        float y = points[(i * 3) + 1];
+        unsigned char *packed = bytes + i * stride;
+
+        if(format == PointFormat::Float2){
+            float xy[2] = { x, y };
+            std::memcpy(packed, xy, sizeof(xy));
+        } else if(format == PointFormat::Half2){
+            uint16_t xy[2] = { floatToHalf(x), floatToHalf(y) };
+            std::memcpy(packed, xy, sizeof(xy));
+        } else{
+            int16_t xy[2] = { floatToSnorm16(x / pointFormatScale(format)), floatToSnorm16(y / pointFormatScale(format)) };
+            std::memcpy(packed, xy, sizeof(xy));
+        }
+    }
+}
+
+void setPointAttribute(PointFormat format){
+    GLsizei stride = static_cast<GLsizei>(pointFormatStride(format));
+    switch(format){
+        case PointFormat::Float2:
+            glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, stride, (void*)0);
+        break;
+        case PointFormat::Half2:
+            glVertexAttribPointer(0, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)0);
+        break;
+        case PointFormat::Short2:
+            glVertexAttribPointer(0, 2, GL_SHORT, GL_TRUE, stride, (void*)0);
+        break;
+        default:
+            // specify how Vertex buffer data is formatted (32bit, positions have 3 values, and tightly packed)
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+    }
+    glEnableVertexAttribArray(0);
+}
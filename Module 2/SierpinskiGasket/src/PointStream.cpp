@@ -0,0 +1,233 @@
+#include "PointStream.h"
+#include "ChaosGame.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+// first batch is tiny so the first frame has something on it, then batches double up to the cap
+static const long long FIRST_BATCH_POINTS = 4096;
+static const long long MAX_BATCH_POINTS = 1 << 20;
+
+// points per vertex buffer, 48 MB of full floats
+static const long long CHUNK_POINTS = 1 << 22;
+// mapped chunks kept ready past the one being filled so the producer doesn't wait on the frame rate
+static const size_t CHUNKS_AHEAD = 3;
+
+PointStream::PointStream(long long iterations, uint64_t seed, ChaosKernel kernel, PointFormat format)
+    : iterations(iterations), seed(seed), kernel(kernel), format(format), persistent(false), uploaded(0), produced(0),
+      stopping(false){
+}
+
+PointStream::~PointStream(){
+    stopping = true;
+    if(producer.joinable()){
+        producer.join();
+    }
+    if(chunkData && !persistent){
+        for(size_t i = 0; i < chunkCount(); i++){
+            delete[] chunkData[i].load();
+        }
+    }
+}
+
+size_t PointStream::chunkCount() const{
+    return static_cast<size_t>((iterations + 3 + CHUNK_POINTS - 1) / CHUNK_POINTS);
+}
+
+long long PointStream::chunkPoints(size_t index) const{
+    return std::min(CHUNK_POINTS, iterations + 3 - static_cast<long long>(index) * CHUNK_POINTS);
+}
+
+bool PointStream::mapChunk(size_t index){
+    GLsizeiptr bufferSize = chunkPoints(index) * pointFormatStride(format);
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    unsigned int buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferStorage(GL_ARRAY_BUFFER, bufferSize, NULL, flags);
+    unsigned char *data = static_cast<unsigned char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, bufferSize, flags));
+    if(!data){
+        glDeleteBuffers(1, &buffer);
+        return false;
+    }
+    buffers.push_back(buffer);
+    chunkData[index].store(data, std::memory_order_release);
+    return true;
+}
+
+void PointStream::start(){
+    chunkData.reset(new std::atomic<unsigned char*>[chunkCount()]);
+    for(size_t i = 0; i < chunkCount(); i++){
+        chunkData[i] = nullptr;
+    }
+
+    // GL 4.4 lets the producer write straight into GPU visible memory, otherwise we copy over each frame
+    persistent = GLAD_GL_VERSION_4_4;
+    if(persistent && !mapChunk(0)){
+        std::cout << "ERROR: PERSISTENT MAPPING FAILED, FALLING BACK TO BUFFER UPLOADS" << std::endl;
+        persistent = false;
+    }
+    if(persistent){
+        while(buffers.size() < std::min(chunkCount(), 1 + CHUNKS_AHEAD) && mapChunk(buffers.size())){
+        }
+    }
+
+    producer = std::thread(&PointStream::produce, this);
+}
+
+unsigned char *PointStream::chunkMemory(size_t index){
+    if(!persistent){
+        // staging memory is ours to make, and isn't zeroed since every byte gets written before it's read
+        unsigned char *data = new unsigned char[chunkPoints(index) * pointFormatStride(format)];
+        chunkData[index].store(data, std::memory_order_release);
+        return data;
+    }
+    unsigned char *data = chunkData[index].load(std::memory_order_acquire);
+    while(!data && !stopping){
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        data = chunkData[index].load(std::memory_order_acquire);
+    }
+    return data;
+}
+
+void PointStream::produce(){
+    size_t stride = pointFormatStride(format);
+    unsigned char *chunk = chunkMemory(0);
+    if(!chunk){
+        return;
+    }
+
+    // shoving bounding triangle in first three of buffer
+    float triangle[9];
+    for(int i = 0; i < 3; i++){
+        triangle[(i * 3)] = TRIANGLE_X[i];
+        triangle[(i * 3) + 1] = TRIANGLE_Y[i];
+        triangle[(i * 3) + 2] = 0.0f; //z-coord
+    }
+    packPoints(format, triangle, 3, chunk);
+    produced.store(3, std::memory_order_release);
+
+    WalkerState walkers;
+    initWalkers(walkers, seed, 0);
+
+    // compact formats go through a batch sized scratch buffer, full floats are written in place
+    std::vector<float> scratch;
+    if(format != PointFormat::Float3){
+        scratch.resize(std::min(iterations, MAX_BATCH_POINTS) * 3);
+    }
+
+    long long total = iterations + 3;
+    long long done = 3;
+    long long batch = FIRST_BATCH_POINTS;
+    while(done < total && !stopping){
+        // batches stop at the end of a chunk, the next one starts in fresh memory
+        long long inChunk = done % CHUNK_POINTS;
+        if(inChunk == 0){
+            chunk = chunkMemory(static_cast<size_t>(done / CHUNK_POINTS));
+            if(!chunk){
+                return;
+            }
+        }
+        long long count = std::min({ batch, total - done, CHUNK_POINTS - inChunk });
+        unsigned char *out = chunk + inChunk * stride;
+        if(format == PointFormat::Float3){
+            runChaosKernel(kernel, walkers, reinterpret_cast<float*>(out), count);
+        } else{
+            runChaosKernel(kernel, walkers, scratch.data(), count);
+            packPoints(format, scratch.data(), count, out);
+        }
+        done += count;
+
+        // publishing the count after the writes is what lets the render thread draw them
+        produced.store(done, std::memory_order_release);
+        batch = std::min(batch * 2, MAX_BATCH_POINTS);
+    }
+}
+
+long long PointStream::update(){
+    long long ready = produced.load(std::memory_order_acquire);
+    size_t stride = pointFormatStride(format);
+
+    if(persistent){
+        // keep a few chunks mapped ahead of the producer
+        size_t wanted = std::min(chunkCount(), static_cast<size_t>(ready / CHUNK_POINTS) + 1 + CHUNKS_AHEAD);
+        while(buffers.size() < wanted && !stopping){
+            if(!mapChunk(buffers.size())){
+                std::cout << "ERROR: COULDN'T MAP CHUNK " << buffers.size() << ", STOPPING THE STREAM AT " << ready
+                          << " POINTS" << std::endl;
+                stopping = true;
+            }
+        }
+        return ready;
+    }
+
+    // send what arrived since last frame, a chunk at a time, and drop each staging copy once it's all sent
+    while(uploaded < ready){
+        size_t index = static_cast<size_t>(uploaded / CHUNK_POINTS);
+        long long inChunk = uploaded % CHUNK_POINTS;
+        long long count = std::min(ready - uploaded, CHUNK_POINTS - inChunk);
+        if(index == buffers.size()){
+            unsigned int buffer;
+            glGenBuffers(1, &buffer);
+            glBindBuffer(GL_ARRAY_BUFFER, buffer);
+            glBufferData(GL_ARRAY_BUFFER, chunkPoints(index) * stride, NULL, GL_DYNAMIC_DRAW);
+            buffers.push_back(buffer);
+        }
+        unsigned char *data = chunkData[index].load(std::memory_order_acquire);
+        glBindBuffer(GL_ARRAY_BUFFER, buffers[index]);
+        glBufferSubData(GL_ARRAY_BUFFER, inChunk * stride, count * stride, data + inChunk * stride);
+        uploaded += count;
+
+        if(inChunk + count == chunkPoints(index)){
+            delete[] data;
+            chunkData[index] = nullptr;
+        }
+    }
+    return ready;
+}
+
+void PointStream::draw(long long count) const{
+    for(long long first = 0; first < count; first += CHUNK_POINTS){
+        glBindBuffer(GL_ARRAY_BUFFER, buffers[first / CHUNK_POINTS]);
+        setPointAttribute(format);
+        glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(std::min(CHUNK_POINTS, count - first)));
+    }
+}
+
+void PointStream::accumulate(DensityRenderer &density, long long first, long long count) const{
+    long long end = first + count;
+    while(first < end){
+        long long inChunk = first % CHUNK_POINTS;
+        long long slice = std::min(end - first, CHUNK_POINTS - inChunk);
+        density.accumulate(buffers[first / CHUNK_POINTS], format, inChunk, slice);
+        first += slice;
+    }
+}
+
+bool PointStream::finished() const{
+    return produced.load(std::memory_order_acquire) == iterations + 3;
+}
+
+void PointStream::release(){
+    stopping = true;
+    if(producer.joinable()){
+        producer.join();
+    }
+
+    for(unsigned int buffer : buffers){
+        if(persistent){
+            glBindBuffer(GL_ARRAY_BUFFER, buffer);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+        }
+        glDeleteBuffers(1, &buffer);
+    }
+    buffers.clear();
+    if(chunkData && !persistent){
+        for(size_t i = 0; i < chunkCount(); i++){
+            delete[] chunkData[i].exchange(nullptr);
+        }
+    }
+    chunkData.reset();
+}
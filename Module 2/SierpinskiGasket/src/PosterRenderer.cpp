@@ -0,0 +1,477 @@
+#include "PosterRenderer.h"
+#include "IFSKernels.h"
+#include "PngWriter.h"
+#include "PointCloudFile.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// points a thread makes before binning them, small enough to stay in L1
+// a multiple of CHAOS_WALKERS so the batches chain into exactly the points one big kernel call would make
+static const long long POSTER_BATCH = 4096;
+
+// most memory the per thread histograms can take together, past that every thread bins straight into one
+// shared set of atomic counts instead, slower on busy pixels but every point is still only made once
+static const size_t POSTER_HISTOGRAM_BYTES = static_cast<size_t>(1) << 30;
+
+// rows tone mapped in parallel before they go to the writer
+static const int TONE_MAP_ROWS = 64;
+
+// side of the square tiles a tiled poster is split into, the last row and column are whatever is left
+static const int POSTER_TILE_SIZE = 4096;
+static_assert(POSTER_TILE_SIZE % TONE_MAP_ROWS == 0, "a tone map block has to stay inside one row of tiles");
+
+// points per independently seeded run inside a tile's subtriangle, threads take these one at a time
+static const long long TILE_CHUNK_POINTS = 1 << 20;
+
+// a tile file is its counts row by row then this word, written last so a worker that dies partway is caught
+static const uint32_t TILE_DONE = 0x454E4F44; // "DONE"
+
+// times a tile gets handed out before the whole render gives up
+static const int MAX_TILE_ATTEMPTS = 3;
+
+// one subtriangle a tile worker generates in, address is its vertex choices as base 3 digits
+struct TileCell {
+    double offsetX;
+    double offsetY;
+    double scale;
+    uint64_t address;
+};
+
+// runs work(thread) on threadCount threads, the calling thread takes thread 0
+template <typename Work>
+static void forEachThread(unsigned int threadCount, Work work){
+    std::vector<std::thread> workers;
+    for(unsigned int t = 1; t < threadCount; t++){
+        workers.emplace_back(work, t);
+    }
+    work(0u);
+    for(std::thread &worker : workers){
+        worker.join();
+    }
+}
+
+// same curve as toneMapFragmentSource, black to the gasket purple to almost white
+static void toneMap(uint32_t count, float logPeak, unsigned char rgb[3]){
+    if(count == 0){
+        rgb[0] = rgb[1] = rgb[2] = 0;
+        return;
+    }
+    float level = std::log(1.0f + count) / logPeak;
+    float low = std::min(std::max(level * 2.0f, 0.0f), 1.0f);
+    float high = std::min(std::max(level * 2.0f - 1.0f, 0.0f), 1.0f);
+    const float purple[3] = { 0.21f, 0.0f, 0.25f };
+    const float white[3] = { 1.0f, 0.85f, 1.0f };
+    for(int c = 0; c < 3; c++){
+        float color = purple[c] * low;
+        color = color + (white[c] - color) * high;
+        rgb[c] = static_cast<unsigned char>(color * 255.0f + 0.5f);
+    }
+}
+
+// tone maps the counts a block of rows at a time and streams them into the PNG. blockCounts(firstRow, rows) gives
+// back those rows' counts one after another, or nullptr if they can't be had, which abandons the image.
+// the counts are uint32_t, or std::atomic<uint32_t> when they were binned by every thread at once
+template <typename BlockCounts>
+static bool writePoster(const std::string &path, int width, int height, uint32_t peak, unsigned int threadCount,
+                        BlockCounts blockCounts){
+    auto writeStart = std::chrono::steady_clock::now();
+    PngWriter writer;
+    if(!writer.open(path, width, height)){
+        return false;
+    }
+    size_t rowPixels = static_cast<size_t>(width);
+    const float logPeak = std::log(1.0f + std::max(peak, 1u));
+    std::vector<unsigned char> rgb(rowPixels * 3 * TONE_MAP_ROWS);
+    for(int firstRow = 0; firstRow < height; firstRow += TONE_MAP_ROWS){
+        int rows = std::min(TONE_MAP_ROWS, height - firstRow);
+        size_t blockPixels = rowPixels * rows;
+        const auto *block = blockCounts(firstRow, rows);
+        if(!block){
+            writer.close();
+            std::remove(path.c_str());
+            return false;
+        }
+        forEachThread(threadCount, [&](unsigned int t){
+            size_t begin = blockPixels * t / threadCount;
+            size_t end = blockPixels * (t + 1) / threadCount;
+            for(size_t i = begin; i < end; i++){
+                toneMap(block[i], logPeak, &rgb[i * 3]);
+            }
+        });
+        for(int row = 0; row < rows; row++){
+            writer.writeRow(&rgb[row * rowPixels * 3]);
+        }
+    }
+    if(!writer.close()){
+        std::cout << "ERROR: COULD NOT WRITE IMAGE " << path << std::endl;
+        return false;
+    }
+    auto writeTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - writeStart);
+    std::cout << "Wrote " << path << " in " << writeTime.count() << " ms" << std::endl;
+    return true;
+}
+
+// runs thread t's share of the chaos game and calls bin(pixel index) for every point that lands in the image
+template <typename Bin>
+static void binPosterPoints(unsigned int t, long long iterations, long long chunkSize, uint64_t seed, ChaosKernel kernel,
+                            int width, int height, Bin bin){
+    // [-0.5, 0.5] across the shorter side, y up in the gasket but rows go down in the image
+    const float pixelsPerUnit = static_cast<float>(std::min(width, height));
+    const float centerX = width * 0.5f;
+    const float centerY = height * 0.5f;
+
+    long long first = std::min(iterations, t * chunkSize);
+    long long chunk = std::min(iterations - first, chunkSize);
+    WalkerState walkers;
+    initWalkers(walkers, seed, t);
+
+    alignas(64) float batch[POSTER_BATCH * 3];
+    for(long long done = 0; done < chunk; done += POSTER_BATCH){
+        long long count = std::min(POSTER_BATCH, chunk - done);
+        runChaosKernel(kernel, walkers, batch, count);
+        for(long long i = 0; i < count; i++){
+            long long column = static_cast<long long>(std::floor(batch[(i * 3)] * pixelsPerUnit + centerX));
+            long long row = static_cast<long long>(std::floor(centerY - batch[(i * 3) + 1] * pixelsPerUnit));
+            if(column >= 0 && column < width && row >= 0 && row < height){
+                bin(static_cast<size_t>(row) * width + column);
+            }
+        }
+    }
+}
+
+bool renderPoster(const std::string &path, int width, int height, long long iterations, unsigned int threadCount,
+                  uint64_t seed, ChaosKernel kernel){
+    auto renderStart = std::chrono::steady_clock::now();
+    if(threadCount == 0){
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threadCount = static_cast<unsigned int>(std::max(1LL, std::min<long long>(threadCount, iterations / MIN_POINTS_PER_THREAD)));
+
+    size_t pixels = static_cast<size_t>(width) * height;
+    const long long chunkSize = (iterations + threadCount - 1) / threadCount;
+    std::vector<uint32_t> peaks(threadCount, 0);
+    bool privateHistograms = threadCount * pixels * sizeof(uint32_t) <= POSTER_HISTOGRAM_BYTES;
+
+    auto reportBinning = [&](uint32_t peak){
+        auto renderTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - renderStart);
+        std::cout << "Binned " << iterations << " points into " << width << "x" << height << " in " << renderTime.count()
+                  << " ms (" << (privateHistograms ? "per thread histograms" : "shared atomic counts") << ", " << threadCount
+                  << " threads, " << chaosKernelName(kernel) << " kernel), densest pixel has " << peak << std::endl;
+    };
+
+    if(privateHistograms){
+        // merged counts for the whole image, every pixel gets written by the merge so no need to clear it
+        std::unique_ptr<uint32_t[]> counts(new uint32_t[pixels]);
+        std::unique_ptr<uint32_t[]> histograms(new uint32_t[threadCount * pixels]);
+        forEachThread(threadCount, [&](unsigned int t){
+            uint32_t *histogram = histograms.get() + t * pixels;
+            std::fill(histogram, histogram + pixels, 0u);
+            binPosterPoints(t, iterations, chunkSize, seed, kernel, width, height, [histogram](size_t pixel){
+                histogram[pixel]++;
+            });
+        });
+
+        // parallel reduction, each thread sums every histogram over its own slice of the image
+        forEachThread(threadCount, [&](unsigned int t){
+            size_t begin = pixels * t / threadCount;
+            size_t end = pixels * (t + 1) / threadCount;
+            uint32_t *merged = counts.get();
+            std::copy(histograms.get() + begin, histograms.get() + end, merged + begin);
+            for(unsigned int other = 1; other < threadCount; other++){
+                const uint32_t *histogram = histograms.get() + other * pixels;
+                for(size_t i = begin; i < end; i++){
+                    merged[i] += histogram[i];
+                }
+            }
+            for(size_t i = begin; i < end; i++){
+                peaks[t] = std::max(peaks[t], merged[i]);
+            }
+        });
+        histograms.reset();
+
+        uint32_t peak = *std::max_element(peaks.begin(), peaks.end());
+        reportBinning(peak);
+        return writePoster(path, width, height, peak, threadCount, [&](int firstRow, int){
+            return counts.get() + firstRow * static_cast<size_t>(width);
+        });
+    }
+
+    // too big for a histogram per thread, so every thread adds into the same counts. the order of the adds
+    // doesn't matter, only the totals, so relaxed is enough
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "shared counts have to take as much memory as plain ones");
+    std::unique_ptr<std::atomic<uint32_t>[]> counts(new std::atomic<uint32_t>[pixels]);
+    forEachThread(threadCount, [&](unsigned int t){
+        for(size_t i = pixels * t / threadCount; i < pixels * (t + 1) / threadCount; i++){
+            counts[i].store(0, std::memory_order_relaxed);
+        }
+    });
+    forEachThread(threadCount, [&](unsigned int t){
+        std::atomic<uint32_t> *shared = counts.get();
+        binPosterPoints(t, iterations, chunkSize, seed, kernel, width, height, [shared](size_t pixel){
+            shared[pixel].fetch_add(1, std::memory_order_relaxed);
+        });
+    });
+    forEachThread(threadCount, [&](unsigned int t){
+        for(size_t i = pixels * t / threadCount; i < pixels * (t + 1) / threadCount; i++){
+            peaks[t] = std::max(peaks[t], counts[i].load(std::memory_order_relaxed));
+        }
+    });
+
+    uint32_t peak = *std::max_element(peaks.begin(), peaks.end());
+    reportBinning(peak);
+    return writePoster(path, width, height, peak, threadCount, [&](int firstRow, int){
+        return counts.get() + firstRow * static_cast<size_t>(width);
+    });
+}
+
+// subtriangle size every tile uses, about one tile across, so which cells a tile gets never depends on the tile
+static int posterCellLevel(int width, int height){
+    int level = static_cast<int>(std::floor(std::log2(static_cast<double>(std::min(width, height)) / POSTER_TILE_SIZE)));
+    return std::max(0, std::min(level, 20));
+}
+
+// same walk as the view mode's, keeping the address so every cell can be seeded the same way in every worker
+static void collectTileCells(const TileCell &cell, int level, int targetLevel, double minX, double maxX, double minY,
+                             double maxY, std::vector<TileCell> &cells){
+    double reach = cell.scale * 0.5;
+    if(cell.offsetX + reach < minX || cell.offsetX - reach > maxX || cell.offsetY + reach < minY || cell.offsetY - reach > maxY){
+        return;
+    }
+    if(level == targetLevel){
+        cells.push_back(cell);
+        return;
+    }
+    for(int d = 0; d < 3; d++){
+        TileCell child = { cell.offsetX + cell.scale * 0.5 * TRIANGLE_X[d], cell.offsetY + cell.scale * 0.5 * TRIANGLE_Y[d],
+                           cell.scale * 0.5, cell.address * 3 + d };
+        collectTileCells(child, level + 1, targetLevel, minX, maxX, minY, maxY, cells);
+    }
+}
+
+bool renderPosterTile(const std::string &tilePath, int width, int height, const PosterTile &tile, long long iterations,
+                      unsigned int threadCount, uint64_t seed, ChaosKernel kernel){
+    if(threadCount == 0){
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    const float pixelsPerUnit = static_cast<float>(std::min(width, height));
+    const float centerX = width * 0.5f;
+    const float centerY = height * 0.5f;
+
+    int level = posterCellLevel(width, height);
+    std::vector<TileCell> cells;
+    collectTileCells({ 0.0, 0.0, 1.0, 0 }, 0, level, (tile.x - centerX) / pixelsPerUnit,
+                     (tile.x + tile.width - centerX) / pixelsPerUnit, (centerY - (tile.y + tile.height)) / pixelsPerUnit,
+                     (centerY - tile.y) / pixelsPerUnit, cells);
+
+    // every level k cell holds exactly 3^-k of the gasket's points, the remainder goes to the lowest addresses
+    long long cellCount = 1;
+    for(int i = 0; i < level; i++){
+        cellCount *= 3;
+    }
+    long long perCell = iterations / cellCount;
+    long long extra = iterations % cellCount;
+
+    // (cell, chunk) pairs, handed out to whichever thread is free
+    std::vector<std::pair<size_t, long long>> work;
+    for(size_t c = 0; c < cells.size(); c++){
+        long long count = perCell + ((static_cast<long long>(cells[c].address) < extra) ? 1 : 0);
+        for(long long chunk = 0; chunk * TILE_CHUNK_POINTS < count; chunk++){
+            work.emplace_back(c, chunk);
+        }
+    }
+
+    size_t tilePixels = static_cast<size_t>(tile.width) * tile.height;
+    std::unique_ptr<uint32_t[]> histograms(new uint32_t[threadCount * tilePixels]);
+    std::atomic<size_t> nextWork(0);
+    forEachThread(threadCount, [&](unsigned int t){
+        uint32_t *histogram = histograms.get() + t * tilePixels;
+        std::fill(histogram, histogram + tilePixels, 0u);
+
+        alignas(64) float batch[POSTER_BATCH * 3];
+        for(size_t w = nextWork++; w < work.size(); w = nextWork++){
+            const TileCell &cell = cells[work[w].first];
+            long long cellPoints = perCell + ((static_cast<long long>(cell.address) < extra) ? 1 : 0);
+            long long first = work[w].second * TILE_CHUNK_POINTS;
+            long long chunk = std::min(TILE_CHUNK_POINTS, cellPoints - first);
+
+            WalkerState walkers;
+            initWalkers(walkers, seed + cell.address * 0x9E3779B97F4A7C15ULL, static_cast<uint64_t>(work[w].second));
+
+            // gasket point p lands at offset + scale * p, folded straight into tile pixels
+            const float cellScale = static_cast<float>(cell.scale * pixelsPerUnit);
+            const float columnOffset = static_cast<float>(cell.offsetX * pixelsPerUnit + centerX - tile.x);
+            const float rowOffset = static_cast<float>(centerY - cell.offsetY * pixelsPerUnit - tile.y);
+            for(long long done = 0; done < chunk; done += POSTER_BATCH){
+                long long count = std::min(POSTER_BATCH, chunk - done);
+                runChaosKernel(kernel, walkers, batch, count);
+                for(long long i = 0; i < count; i++){
+                    long long column = static_cast<long long>(std::floor(batch[(i * 3)] * cellScale + columnOffset));
+                    long long row = static_cast<long long>(std::floor(rowOffset - batch[(i * 3) + 1] * cellScale));
+                    if(column >= 0 && column < tile.width && row >= 0 && row < tile.height){
+                        histogram[row * tile.width + column]++;
+                    }
+                }
+            }
+        }
+    });
+
+    MappedFile file;
+    if(!file.create(tilePath, tilePixels * sizeof(uint32_t) + sizeof(TILE_DONE))){
+        std::cout << "ERROR: COULD NOT CREATE TILE FILE " << tilePath << std::endl;
+        return false;
+    }
+    uint32_t *merged = reinterpret_cast<uint32_t*>(file.data());
+    forEachThread(threadCount, [&](unsigned int t){
+        size_t begin = tilePixels * t / threadCount;
+        size_t end = tilePixels * (t + 1) / threadCount;
+        std::copy(histograms.get() + begin, histograms.get() + end, merged + begin);
+        for(unsigned int other = 1; other < threadCount; other++){
+            const uint32_t *histogram = histograms.get() + other * tilePixels;
+            for(size_t i = begin; i < end; i++){
+                merged[i] += histogram[i];
+            }
+        }
+    });
+    merged[tilePixels] = TILE_DONE;
+    file.close();
+    return true;
+}
+
+// maps a tile file for reading, it only counts as done once it's the right size and ends with the marker
+static bool openTile(MappedFile &file, const std::string &tilePath, const PosterTile &tile){
+    size_t tilePixels = static_cast<size_t>(tile.width) * tile.height;
+    if(!file.openRead(tilePath) || file.size() != tilePixels * sizeof(uint32_t) + sizeof(TILE_DONE)
+       || reinterpret_cast<const uint32_t*>(file.data())[tilePixels] != TILE_DONE){
+        file.close();
+        return false;
+    }
+    return true;
+}
+
+static bool tileFinished(const std::string &tilePath, const PosterTile &tile){
+    MappedFile file;
+    return openTile(file, tilePath, tile);
+}
+
+bool renderPosterTiled(const std::string &path, const std::string &executable, int width, int height, long long iterations,
+                       unsigned int workerCount, unsigned int threadCount, uint64_t seed, ChaosKernel kernel){
+    auto renderStart = std::chrono::steady_clock::now();
+    if(workerCount == 0){
+        workerCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    // the workers already run side by side, by default each one sticks to a single thread
+    unsigned int workerThreads = (threadCount == 0) ? 1 : threadCount;
+
+    std::vector<PosterTile> tiles;
+    for(int y = 0; y < height; y += POSTER_TILE_SIZE){
+        for(int x = 0; x < width; x += POSTER_TILE_SIZE){
+            tiles.push_back({ x, y, std::min(POSTER_TILE_SIZE, width - x), std::min(POSTER_TILE_SIZE, height - y) });
+        }
+    }
+
+    // one thread per worker slot, each one starts a process for the next tile and waits for it
+    std::atomic<size_t> nextTile(0);
+    std::atomic<bool> failed(false);
+    forEachThread(std::min<unsigned int>(workerCount, static_cast<unsigned int>(tiles.size())), [&](unsigned int){
+        for(size_t i = nextTile++; i < tiles.size() && !failed; i = nextTile++){
+            const PosterTile &tile = tiles[i];
+            std::string tilePath = path + ".tile" + std::to_string(i);
+            std::string command = "\"" + executable + "\" --poster-tile \"" + tilePath + "\" " + std::to_string(tile.x) + " "
+                                  + std::to_string(tile.y) + " " + std::to_string(tile.width) + " " + std::to_string(tile.height)
+                                  + " --poster-size " + std::to_string(width) + " " + std::to_string(height)
+                                  + " --points " + std::to_string(iterations) + " --seed " + std::to_string(seed)
+                                  + " --threads " + std::to_string(workerThreads) + " --kernel " + chaosKernelArgument(kernel);
+#ifdef _WIN32
+            command = "\"" + command + "\""; // cmd strips the outer quotes and keeps the rest
+#endif
+            bool done = false;
+            for(int attempt = 1; attempt <= MAX_TILE_ATTEMPTS && !done; attempt++){
+                std::remove(tilePath.c_str());
+                int status = std::system(command.c_str());
+                done = status == 0 && tileFinished(tilePath, tile);
+                if(!done){
+                    std::cout << "WARNING: tile " << i << " failed on attempt " << attempt << " of " << MAX_TILE_ATTEMPTS
+                              << std::endl;
+                }
+            }
+            if(!done){
+                std::cout << "ERROR: GAVE UP ON TILE " << i << std::endl;
+                failed = true;
+            }
+        }
+    });
+
+    auto removeTiles = [&](){
+        for(size_t i = 0; i < tiles.size(); i++){
+            std::remove((path + ".tile" + std::to_string(i)).c_str());
+        }
+    };
+    if(failed){
+        removeTiles();
+        return false;
+    }
+
+    // the peak first, the tone map needs it before the first row goes out
+    uint32_t peak = 0;
+    for(size_t i = 0; i < tiles.size(); i++){
+        MappedFile file;
+        if(!openTile(file, path + ".tile" + std::to_string(i), tiles[i])){
+            std::cout << "ERROR: COULD NOT READ TILE " << i << std::endl;
+            removeTiles();
+            return false;
+        }
+        const uint32_t *tileCounts = reinterpret_cast<const uint32_t*>(file.data());
+        peak = std::max(peak, *std::max_element(tileCounts, tileCounts + static_cast<size_t>(tiles[i].width) * tiles[i].height));
+    }
+
+    auto renderTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - renderStart);
+    std::cout << "Binned " << iterations << " points into " << width << "x" << height << " in " << renderTime.count()
+              << " ms (" << tiles.size() << " tiles over " << workerCount << " worker processes, " << chaosKernelName(kernel)
+              << " kernel), densest pixel has " << peak << std::endl;
+
+    // then one row of tiles at a time, stitched a block of rows at a time, so the whole image never is in memory.
+    // tiles are in rows of tilesPerRow and a block never crosses into the next row since the tile size is a multiple
+    // of TONE_MAP_ROWS
+    size_t tilesPerRow = (width + POSTER_TILE_SIZE - 1) / POSTER_TILE_SIZE;
+    std::unique_ptr<MappedFile[]> rowFiles(new MappedFile[tilesPerRow]);
+    int mappedTileRow = -1;
+    std::vector<uint32_t> block(static_cast<size_t>(width) * TONE_MAP_ROWS);
+    bool written = writePoster(path, width, height, peak, std::max(1u, std::thread::hardware_concurrency()),
+                               [&](int firstRow, int rows) -> const uint32_t*{
+        int tileRow = firstRow / POSTER_TILE_SIZE;
+        if(tileRow != mappedTileRow){
+            for(size_t column = 0; column < tilesPerRow; column++){
+                size_t i = tileRow * tilesPerRow + column;
+                if(!openTile(rowFiles[column], path + ".tile" + std::to_string(i), tiles[i])){
+                    std::cout << "ERROR: COULD NOT READ TILE " << i << std::endl;
+                    return nullptr;
+                }
+            }
+            mappedTileRow = tileRow;
+        }
+        for(size_t column = 0; column < tilesPerRow; column++){
+            const PosterTile &tile = tiles[tileRow * tilesPerRow + column];
+            const uint32_t *tileCounts = reinterpret_cast<const uint32_t*>(rowFiles[column].data());
+            for(int row = firstRow; row < firstRow + rows; row++){
+                const uint32_t *source = tileCounts + static_cast<size_t>(row - tile.y) * tile.width;
+                std::copy(source, source + tile.width, block.data() + static_cast<size_t>(row - firstRow) * width + tile.x);
+            }
+        }
+        return block.data();
+    });
+
+    for(size_t column = 0; column < tilesPerRow; column++){
+        rowFiles[column].close();
+    }
+    removeTiles();
+    return written;
+}
@@ -0,0 +1,160 @@
+#include "RaymarchRenderer.h"
+#include "GasketShaders.h"
+
+#include <cmath>
+#include <iostream>
+
+#include <glad/glad.h>
+
+// vertical field of view in radians
+static const float FIELD_OF_VIEW = 0.785398f;
+
+// pixel of each 2x2 block traced on each frame, diagonals first so every block gets spread out samples soonest
+static const int TRACE_ORDER[4][2] = { { 0, 0 }, { 1, 1 }, { 1, 0 }, { 0, 1 } };
+
+// low discrepancy sequence for the sub pixel jitter, a still camera ends up averaging an antialiased image
+static float halton(long long index, int base){
+    float result = 0.0f;
+    float fraction = 1.0f;
+    while(index > 0){
+        fraction /= base;
+        result += fraction * (index % base);
+        index /= base;
+    }
+    return result;
+}
+
+static unsigned int createTexture(int width, int height, GLenum internalFormat, GLenum format, GLenum filter){
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    return texture;
+}
+
+RaymarchRenderer::RaymarchRenderer(int width, int height) : width(width), height(height), current(0), frame(0),
+                                                            historyLevels(-1), previousBasis(){
+    traceProgram = compileProgram(fullscreenVertexSource, raymarchTraceSource);
+    resolveProgram = compileProgram(fullscreenVertexSource, raymarchResolveSource);
+    glGenVertexArrays(1, &emptyVAO);
+
+    // rounded up so the last row and column of blocks still get traced
+    traceTexture = createTexture((width + 1) / 2, (height + 1) / 2, GL_RGBA32F, GL_RGBA, GL_NEAREST);
+    glGenFramebuffers(1, &traceFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, traceFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, traceTexture, 0);
+    if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE){
+        std::cout << "ERROR: RAYMARCH TRACE FRAMEBUFFER INCOMPLETE" << std::endl;
+    }
+
+    // the color is sampled between texels when reprojecting, the depth only ever at one
+    const GLenum drawBuffers[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glGenFramebuffers(2, historyFBO);
+    for(int i = 0; i < 2; i++){
+        historyColor[i] = createTexture(width, height, GL_RGBA16F, GL_RGBA, GL_LINEAR);
+        historyDepth[i] = createTexture(width, height, GL_R32F, GL_RED, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, historyFBO[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, historyColor[i], 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, historyDepth[i], 0);
+        glDrawBuffers(2, drawBuffers);
+        if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE){
+            std::cout << "ERROR: RAYMARCH HISTORY FRAMEBUFFER INCOMPLETE" << std::endl;
+        }
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // samplers never change, the resolve always reads the trace from unit 0 and the history from 1 and 2
+    glUseProgram(resolveProgram);
+    glUniform1i(glGetUniformLocation(resolveProgram, "current"), 0);
+    glUniform1i(glGetUniformLocation(resolveProgram, "historyColor"), 1);
+    glUniform1i(glGetUniformLocation(resolveProgram, "historyDepth"), 2);
+}
+
+// both passes build rays the same way, so they get the same camera uniforms
+static void setCamera(unsigned int program, const float basis[4][3], int width, int height){
+    float tanHalfFov = std::tan(FIELD_OF_VIEW * 0.5f);
+    glUniform3fv(glGetUniformLocation(program, "cameraPosition"), 1, basis[0]);
+    glUniform3fv(glGetUniformLocation(program, "cameraRight"), 1, basis[1]);
+    glUniform3fv(glGetUniformLocation(program, "cameraUp"), 1, basis[2]);
+    glUniform3fv(glGetUniformLocation(program, "cameraForward"), 1, basis[3]);
+    glUniform2f(glGetUniformLocation(program, "viewScale"), tanHalfFov * width / height, tanHalfFov);
+    glUniform2f(glGetUniformLocation(program, "resolution"), static_cast<float>(width), static_cast<float>(height));
+}
+
+void RaymarchRenderer::draw(const OrbitCamera &camera, int levels){
+    // position on the orbit and a basis looking back at the origin with y up
+    float cosPitch = std::cos(camera.pitch);
+    float basis[4][3] = {
+        { camera.distance * cosPitch * std::sin(camera.yaw), camera.distance * std::sin(camera.pitch),
+          camera.distance * cosPitch * std::cos(camera.yaw) },
+        { std::cos(camera.yaw), 0.0f, -std::sin(camera.yaw) },
+        { -std::sin(camera.pitch) * std::sin(camera.yaw), cosPitch, -std::sin(camera.pitch) * std::cos(camera.yaw) },
+        { -cosPitch * std::sin(camera.yaw), -std::sin(camera.pitch), -cosPitch * std::cos(camera.yaw) }
+    };
+
+    const int *traced = TRACE_ORDER[frame % 4];
+    long long round = (frame / 4) + 1;
+    bool historyValid = frame > 0 && levels == historyLevels;
+
+    // quarter of the rays at half resolution
+    glBindFramebuffer(GL_FRAMEBUFFER, traceFBO);
+    glViewport(0, 0, (width + 1) / 2, (height + 1) / 2);
+    glUseProgram(traceProgram);
+    setCamera(traceProgram, basis, width, height);
+    glUniform2f(glGetUniformLocation(traceProgram, "sampleOffset"), traced[0] + halton(round, 2), traced[1] + halton(round, 3));
+    glUniform1i(glGetUniformLocation(traceProgram, "levels"), levels);
+    glBindVertexArray(emptyVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    // merge them with last frame's image into the other history buffer
+    int previous = 1 - current;
+    glBindFramebuffer(GL_FRAMEBUFFER, historyFBO[current]);
+    glViewport(0, 0, width, height);
+    glUseProgram(resolveProgram);
+    setCamera(resolveProgram, basis, width, height);
+    glUniform2i(glGetUniformLocation(resolveProgram, "tracedPixel"), traced[0], traced[1]);
+    glUniform1i(glGetUniformLocation(resolveProgram, "historyValid"), historyValid);
+    glUniform3fv(glGetUniformLocation(resolveProgram, "previousPosition"), 1, previousBasis[0]);
+    glUniform3fv(glGetUniformLocation(resolveProgram, "previousRight"), 1, previousBasis[1]);
+    glUniform3fv(glGetUniformLocation(resolveProgram, "previousUp"), 1, previousBasis[2]);
+    glUniform3fv(glGetUniformLocation(resolveProgram, "previousForward"), 1, previousBasis[3]);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, traceTexture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, historyColor[previous]);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, historyDepth[previous]);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glActiveTexture(GL_TEXTURE0);
+
+    // the resolved image is also what gets shown
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, historyFBO[current]);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    for(int row = 0; row < 4; row++){
+        for(int axis = 0; axis < 3; axis++){
+            previousBasis[row][axis] = basis[row][axis];
+        }
+    }
+    historyLevels = levels;
+    current = previous;
+    frame++;
+}
+
+void RaymarchRenderer::release(){
+    glDeleteFramebuffers(1, &traceFBO);
+    glDeleteFramebuffers(2, historyFBO);
+    glDeleteTextures(1, &traceTexture);
+    glDeleteTextures(2, historyColor);
+    glDeleteTextures(2, historyDepth);
+    glDeleteVertexArrays(1, &emptyVAO);
+    glDeleteProgram(traceProgram);
+    glDeleteProgram(resolveProgram);
+}
@@ -1,37 +1,110 @@
 #include <iostream>
 #include <cstdlib>
 #include <ctime>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
 #include <vector>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
-// function defintion
-void constructSierpinshi(int iterations, float vertices[]);
+#include "ChaosGame.h"
+#include "CloudStreamer.h"
+#include "DensityRenderer.h"
+#include "GasketMesh.h"
+#include "GasketSettings.h"
+#include "GasketShaders.h"
+#include "MortonOrder.h"
+#include "PointCloudFile.h"
+#include "PointFormat.h"
+#include "PointStream.h"
+#include "PosterRenderer.h"
+#include "RaymarchRenderer.h"
+
+// function definitions
+void processInput(GLFWwindow *window, int &level, GasketView &view, float deltaTime);
+void processOrbitInput(GLFWwindow *window, OrbitCamera &camera, float deltaTime);
+void setAnalyticView(unsigned int program, const GasketView &view);
+void benchmarkPointOrder(GLFWwindow *window, const GasketSettings &settings, unsigned int shaderProgram);
 
 // settings
 const unsigned int SCR_WIDTH = 1440;
 const unsigned int SCR_HEIGHT = 1080;
 
-const char *vertexShaderSource = "#version 330 core\n"
-    "layout (location = 0) in vec3 aPos;\n"
-    "void main()\n"
-    "{\n"
-    "   gl_Position = vec4(aPos.x, aPos.y, aPos.z, 1.0);\n"
-    "   gl_PointSize =   5.0;\n"
-    "}\0";
-
-const char *fragmentShaderSource = "#version 330 core\n"
-    "out vec4 FragColor;\n"
-    "void main()\n"
-    "{\n"
-    "    FragColor = vec4(0.21f, 0.0f, 0.25f, 1.0f);\n"
-    "}\0"; 
-
-int main(void)
+// midpoint steps each GPU generated point takes, 24 halvings is below float precision
+const int GPU_POINT_DEPTH = 24;
+
+// gpu points per glDrawArrays, the count is a GLsizei so bigger requests are split
+const long long GPU_POINTS_PER_DRAW = 1 << 30;
+
+// deepest level the instanced mode steps to, 3^15 is already 14 million instances
+const int MAX_INSTANCED_LEVEL = 15;
+
+// double-float coordinates hold about 48 bits, folding deeper than that is just noise
+const int MAX_ANALYTIC_LEVELS = 48;
+
+// folds the raymarcher can take, past about 20 the tetrahedra are smaller than float precision at the origin
+const int MAX_RAYMARCH_LEVELS = 15;
+
+// frames --benchmark times for each point order, after a few untimed ones to settle the driver
+const int BENCHMARK_FRAMES = 30;
+const int BENCHMARK_WARMUP_FRAMES = 3;
+
+// most cloud points in each of the cloud streamer's two buffers, 64 MB as shorts
+const long long CLOUD_BUDGET_POINTS = 1 << 24;
+
+// delta time
+float deltaTime = 0.0f;
+float lastframe = 0.0f;
+
+int main(int argc, char *argv[])
 {
-    // seeding random function
-    srand(static_cast<unsigned int>(time(0)));
+    // seed, thread count and point count come from the command line
+    GasketSettings settings = parseSettings(argc, argv);
+    auto startTime = std::chrono::steady_clock::now();
+
+    // a cloud file is written once and mapped on every run after, so restarts don't regenerate anything
+    PointCloudFile cloud;
+    if(!settings.cloudPath.empty()){
+        if(pointCloudNeedsBuild(settings.cloudPath)){
+            buildPointCloud(settings.cloudPath, settings.fractal, settings.iterations, settings.cloudDepth, settings.format,
+                            settings.threads, settings.seed, settings.kernel);
+        }
+        if(!cloud.open(settings.cloudPath)){
+            return -1;
+        }
+        // an existing file is drawn as it is, whatever the command line asked for
+        if(cloud.fractal() != settings.fractal || cloud.pointCount() != settings.iterations || cloud.format() != settings.format){
+            std::cout << "WARNING: " << settings.cloudPath << " holds " << cloud.pointCount() << " " << fractalName(cloud.fractal())
+                      << " points as " << pointFormatName(cloud.format()) << ", not the " << settings.iterations << " "
+                      << fractalName(settings.fractal) << " points as " << pointFormatName(settings.format)
+                      << " asked for, delete it to build it again" << std::endl;
+        }
+        settings.format = cloud.format();
+        std::cout << "Mapped " << cloud.pointCount() << " points from " << settings.cloudPath << std::endl;
+    }
+
+    // posters are made entirely on the CPU, render boxes don't need a GPU or a display
+    if(!settings.posterTilePath.empty()){
+        bool rendered = renderPosterTile(settings.posterTilePath, settings.posterWidth, settings.posterHeight, settings.posterTile,
+                                         settings.iterations, settings.threads, settings.seed, settings.kernel);
+        return rendered ? 0 : -1;
+    }
+    if(!settings.posterPath.empty()){
+        bool rendered;
+        if(settings.posterWorkers > 0){
+            // workers are this same executable started again with --poster-tile
+            rendered = renderPosterTiled(settings.posterPath, argv[0], settings.posterWidth, settings.posterHeight,
+                                         settings.iterations, settings.posterWorkers, settings.threads, settings.seed,
+                                         settings.kernel);
+        } else{
+            rendered = renderPoster(settings.posterPath, settings.posterWidth, settings.posterHeight, settings.iterations,
+                                    settings.threads, settings.seed, settings.kernel);
+        }
+        return rendered ? 0 : -1;
+    }
 
     /* creating GLFW window*/
     // initialize GLFW
@@ -61,105 +134,311 @@ int main(void)
 
 
     /*------------------- build and compile shaders ---------------------------------------*/
-    // create our vertex shader object
-    unsigned int vertexShader; // this is the ID of the vertex shader
-    vertexShader = glCreateShader(GL_VERTEX_SHADER);
-
-    // Attach source code to vertex shader and compile shader
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
-
-    // Status check on our vertex Shader compiler
-    int  success; // success code
-    char infoLog[512]; // error log buffer
-    
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success); // actual code to check shader
-    if(!success){
-        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-        std::cout << "ERROR: VERTEX SHADER COMPILATION FAILED\n" << infoLog << std::endl;
-    }
-
-
-    // create our fragment shader object
-    unsigned int fragmentShader;
-    fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
-
-    // sanity check on fragment shader
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success); // actual code to check shader
-    if(!success){
-        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-        std::cout << "ERROR: FRAGMENT SHADER COMPILATION FAILED\n" << infoLog << std::endl;
-    }
-    // now that we have shaders. it is time to combine them into a program and link them
-    // create shader program
     unsigned int shaderProgram;
-    shaderProgram = glCreateProgram();
-
-    // attach and link vertex and fragment shaders. ORDER MATTERS!!!!
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-
-    // sanity check on shader program
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if(!success) {
-        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-        std::cout << "ERROR: SHADER PROGRAM FAILED\n" << infoLog << std::endl;
+    if(settings.mode == RenderMode::GpuPoints){
+        shaderProgram = compileProgram(gpuPointVertexSource, fragmentShaderSource);
+    } else if(settings.mode == RenderMode::Instanced){
+        shaderProgram = compileProgram(instancedVertexSource, fragmentShaderSource);
+    } else if(settings.mode == RenderMode::Analytic){
+        shaderProgram = compileProgram(fullscreenVertexSource, analyticFragmentSource);
+    } else if(settings.mode == RenderMode::Raymarch){
+        // the renderer has its own programs
+        shaderProgram = 0;
+    } else if(cloud.isOpen()){
+        shaderProgram = compileProgram(cloudVertexSource, fragmentShaderSource);
+        glUseProgram(shaderProgram);
+        glUniform1f(glGetUniformLocation(shaderProgram, "positionScale"), pointFormatScale(settings.format));
+    } else if(settings.format != PointFormat::Float3){
+        shaderProgram = compileProgram(compactPointVertexSource, fragmentShaderSource);
+        glUseProgram(shaderProgram);
+        glUniform1f(glGetUniformLocation(shaderProgram, "positionScale"), pointFormatScale(settings.format));
+    } else{
+        shaderProgram = compileProgram(vertexShaderSource, fragmentShaderSource);
     }
 
-    // shaders are linked and attached so we can delete them now
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);  
+    // the benchmark makes its own buffers and quits when it's done
+    if(settings.benchmark){
+        benchmarkPointOrder(window, settings, shaderProgram);
+        glDeleteProgram(shaderProgram);
+        glfwTerminate();
+        return 0;
+    }
 
     /* building and creating buffers*/
 
-    int iterations = 10000;
-    float vertices[iterations * 3];
-    constructSierpinshi(iterations, vertices);
-
-    // create a Vertex Buffer Object and Vertex Attribute Object to send to the GPU
-    unsigned int VBO, VAO;
+    // create a Vertex Attribute Object to hold the point layout
+    unsigned int VBO = 0, EBO = 0, VAO;
     glGenVertexArrays(1,&VAO);
-    glGenBuffers(1, &VBO);
 
     // bind VAO 
     glBindVertexArray(VAO);
 
-    // bind VBO
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    long long iterations = settings.iterations;
+    GLsizei pointCount = 0;
+    GLsizei indexCount = 0;
+    GLenum indexType = GL_UNSIGNED_INT;
+    PointStream stream(iterations, settings.seed, settings.kernel, settings.format);
+    CloudStreamer cloudStreamer(cloud, CLOUD_BUDGET_POINTS);
+
+    if(settings.mode == RenderMode::GpuPoints){
+        // nothing to upload, the vertex shader builds each point from gl_VertexID and the VAO stays empty
+        glUseProgram(shaderProgram);
+        glUniform1ui(glGetUniformLocation(shaderProgram, "seed"), static_cast<unsigned int>(settings.seed));
+        glUniform1i(glGetUniformLocation(shaderProgram, "depth"), GPU_POINT_DEPTH);
+    } else if(settings.mode == RenderMode::Mesh){
+        // the exact level N gasket, 3^N triangles instead of millions of random points
+        auto buildStart = std::chrono::steady_clock::now();
+        GasketMesh mesh = buildGasketMesh(settings.level, settings.threads);
+        auto buildTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart);
+        std::cout << "Built level " << mesh.level << " gasket (" << mesh.indexCount() / 3 << " triangles, "
+                  << mesh.vertices.size() / 3 << " vertices) in " << buildTime.count() << " ms" << std::endl;
+
+        glGenBuffers(1, &VBO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(float), mesh.vertices.data(), GL_STATIC_DRAW);
+
+        // element buffer binding is part of the VAO so it only needs binding here
+        glGenBuffers(1, &EBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indexCount() * mesh.indexSize(), mesh.indexData(), GL_STATIC_DRAW);
+
+        indexCount = static_cast<GLsizei>(mesh.indexCount());
+        indexType = mesh.indexSize() == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    } else if(settings.mode == RenderMode::ViewPoints){
+        // filled in the render loop every time the view moves
+        glGenBuffers(1, &VBO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    } else if(settings.mode == RenderMode::Analytic || settings.mode == RenderMode::Raymarch){
+        // nothing to upload, the full screen triangle is made from gl_VertexID
+    } else if(settings.mode == RenderMode::Instanced){
+        // the whole gasket is this one triangle (36 bytes), the instance ID places every copy
+        float triangle[9];
+        for(int i = 0; i < 3; i++){
+            triangle[(i * 3)] = TRIANGLE_X[i];
+            triangle[(i * 3) + 1] = TRIANGLE_Y[i];
+            triangle[(i * 3) + 2] = 0.0f;
+        }
+        glGenBuffers(1, &VBO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(triangle), triangle, GL_STATIC_DRAW);
+    } else if(cloud.isOpen()){
+        // filled in the background once we know what the view can see
+        cloudStreamer.start();
+    } else if(settings.stream){
+        // the producer fills chunk buffers while we draw, streamedCount grows every frame
+        stream.start();
+    } else{
+        // points live on the heap, a stack array overflows long before the counts we want
+        std::vector<float> vertices;
+
+        auto generationStart = std::chrono::steady_clock::now();
+        if(settings.converge){
+            // as many points as this window needs to stop filling in
+            iterations = constructSierpinskiConverged(vertices, SCR_WIDTH, SCR_HEIGHT, settings.threads, settings.seed,
+                                                      settings.kernel, settings.morton);
+        } else{
+            vertices.resize(fractalFloatCount(settings.fractal, iterations));
+            constructFractal(settings.fractal, iterations, vertices.data(), settings.threads, settings.seed, settings.kernel,
+                             settings.morton);
+        }
+        auto generationTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - generationStart);
+        std::cout << "Generated " << iterations << " " << fractalName(settings.fractal) << " points in "
+                  << generationTime.count() << " ms (" << chaosKernelName(settings.kernel) << " kernel)" << std::endl;
+
+        // compact formats get packed over the front of the same buffer, no second copy of the points
+        pointCount = static_cast<GLsizei>(vertices.size() / 3);
+        size_t uploadSize = pointCount * pointFormatStride(settings.format);
+        packPoints(settings.format, vertices.data(), pointCount, vertices.data());
+        std::cout << "Uploading " << uploadSize / (1024.0 * 1024.0) << " MB of " << pointFormatName(settings.format)
+                  << " points" << std::endl;
+
+        // create a Vertex Buffer Object to send to the GPU
+        glGenBuffers(1, &VBO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, uploadSize, vertices.data(), GL_STATIC_DRAW);
+
+        // the GPU has its own copy now so the points go away with this scope
+    }
 
-    // specify how Vertex buffer data is formatted (32bit, positions have 3 values, and tightly packed)
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);  
+    if(VBO != 0){
+        // mesh and instanced buffers are always full (x, y, z) floats
+        setPointAttribute(settings.format);
+    }
 
     // enabling point size to be changed by vertex renderer
     glEnable(GL_PROGRAM_POINT_SIZE);
 
+    // density mode bins the points per pixel once and only tone maps every frame after that
+    std::unique_ptr<DensityRenderer> density;
+    long long accumulated = 0;
+    if(settings.density){
+        if(DensityRenderer::supported()){
+            density = std::make_unique<DensityRenderer>(SCR_WIDTH, SCR_HEIGHT);
+        } else{
+            std::cout << "ERROR: DENSITY MODE NEEDS OPENGL 4.3, DRAWING POINTS INSTEAD" << std::endl;
+        }
+    }
+
+    // the 3D tetrahedron keeps its half resolution trace and the last frame's image between frames
+    std::unique_ptr<RaymarchRenderer> raymarcher;
+    OrbitCamera orbit;
+    if(settings.mode == RenderMode::Raymarch){
+        raymarcher = std::make_unique<RaymarchRenderer>(SCR_WIDTH, SCR_HEIGHT);
+    }
+
     /* rendering time baby!*/
+    int level = settings.level;
+    int uploadedLevel = -1;
+    GasketView view = settings.view;
+    bool firstFrame = true;
+    std::vector<float> viewVertices;
+    GasketView generatedView;
+    bool viewGenerated = false;
+    bool streamReported = false;
+    long long streamedCount = 0;
     while (!glfwWindowShouldClose(window))
     {
+        // calculating delta time
+        float currentFrame = glfwGetTime();
+        deltaTime = currentFrame - lastframe;
+        lastframe = currentFrame;
+
+        // input
+        if(raymarcher){
+            processOrbitInput(window, orbit, deltaTime);
+            processInput(window, level, view, 0.0f);
+        } else{
+            processInput(window, level, view, deltaTime);
+        }
+
+        // pick up whatever the producer finished since last frame
+        if(settings.stream){
+            streamedCount = stream.update();
+            if(!streamReported && stream.finished()){
+                auto streamTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime);
+                std::cout << "Streamed " << iterations << " points in " << streamTime.count() << " ms" << std::endl;
+                streamReported = true;
+            }
+        }
+
         // Black Background
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
 
-        // Draw our triangle
-        glUseProgram(shaderProgram);
-        glBindVertexArray(VAO);
-        glDrawArrays(GL_POINTS, 0, iterations);
+        if(density){
+            // only points we haven't binned yet go through the compute pass
+            if(settings.stream){
+                stream.accumulate(*density, accumulated, streamedCount - accumulated);
+                accumulated = streamedCount;
+            } else if(settings.mode == RenderMode::GpuPoints){
+                if(iterations > accumulated){
+                    density->accumulateGenerated(iterations, static_cast<uint32_t>(settings.seed), GPU_POINT_DEPTH);
+                    accumulated = iterations;
+                }
+            } else if(pointCount > accumulated){
+                density->accumulate(VBO, settings.format, accumulated, pointCount - accumulated);
+                accumulated = pointCount;
+            }
+            density->draw();
+        } else if(settings.mode == RenderMode::Mesh){
+            glUseProgram(shaderProgram);
+            glBindVertexArray(VAO);
+            glDrawElements(GL_TRIANGLES, indexCount, indexType, (void*)0);
+        } else if(settings.mode == RenderMode::Analytic){
+            // one triangle covering the screen, the fragment shader does all the work
+            glUseProgram(shaderProgram);
+            setAnalyticView(shaderProgram, view);
+            glBindVertexArray(VAO);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+        } else if(raymarcher){
+            // fold depth doesn't change the cost, so it goes as deep as the instanced mode
+            raymarcher->draw(orbit, std::min(level, MAX_RAYMARCH_LEVELS));
+        } else if(settings.mode == RenderMode::Instanced){
+            glUseProgram(shaderProgram);
+
+            // changing level is one uniform and a different instance count, nothing gets rebuilt
+            if(level != uploadedLevel){
+                glUniform1i(glGetUniformLocation(shaderProgram, "level"), level);
+                uploadedLevel = level;
+            }
+            glBindVertexArray(VAO);
+            glDrawArraysInstanced(GL_TRIANGLES, 0, 3, static_cast<GLsizei>(gasketMeshTriangleCount(level)));
+        } else if(settings.mode == RenderMode::ViewPoints){
+            // same number of points at every zoom, so only what the camera can see gets made
+            bool viewMoved = view.centerX != generatedView.centerX || view.centerY != generatedView.centerY
+                             || view.zoom != generatedView.zoom;
+            if(!viewGenerated || viewMoved){
+                viewVertices.resize(iterations * 3);
+                constructSierpinskiView(iterations, viewVertices.data(), view.centerX, view.centerY, view.zoom,
+                                        settings.threads, settings.seed, settings.kernel);
+                glBindBuffer(GL_ARRAY_BUFFER, VBO);
+                glBufferData(GL_ARRAY_BUFFER, viewVertices.size() * sizeof(float), viewVertices.data(), GL_STREAM_DRAW);
+                pointCount = static_cast<GLsizei>(iterations);
+                generatedView = view;
+                viewGenerated = true;
+            }
+            glUseProgram(shaderProgram);
+            glBindVertexArray(VAO);
+            glDrawArrays(GL_POINTS, 0, pointCount);
+        } else if(cloud.isOpen()){
+            cloudStreamer.update(view, SCR_WIDTH, SCR_HEIGHT);
+            glUseProgram(shaderProgram);
+            glUniform2f(glGetUniformLocation(shaderProgram, "viewCenter"), static_cast<float>(view.centerX),
+                        static_cast<float>(view.centerY));
+            glUniform1f(glGetUniformLocation(shaderProgram, "viewZoom"), static_cast<float>(view.zoom));
+            glBindVertexArray(VAO);
+            cloudStreamer.draw();
+        } else if(settings.mode == RenderMode::GpuPoints){
+            glUseProgram(shaderProgram);
+            glBindVertexArray(VAO);
+            for(long long base = 0; base < iterations; base += GPU_POINTS_PER_DRAW){
+                glUniform1ui(glGetUniformLocation(shaderProgram, "base"), static_cast<unsigned int>(base));
+                glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(std::min(GPU_POINTS_PER_DRAW, iterations - base)));
+            }
+        } else if(settings.stream){
+            // one draw per chunk, each chunk is its own buffer
+            glUseProgram(shaderProgram);
+            glBindVertexArray(VAO);
+            stream.draw(streamedCount);
+        } else{
+            // Draw our triangle
+            glUseProgram(shaderProgram);
+            glBindVertexArray(VAO);
+            glDrawArrays(GL_POINTS, 0, pointCount);
+        }
 
         /* Swap front and back buffers */
         glfwSwapBuffers(window);
 
+        if(firstFrame){
+            auto firstFrameTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime);
+            std::cout << "First frame after " << firstFrameTime.count() << " ms" << std::endl;
+            firstFrame = false;
+        }
+
         /* Poll for and process events */
         glfwPollEvents();
     }
 
     // Clean up
+    if(density){
+        density->release();
+    }
+    if(raymarcher){
+        raymarcher->release();
+    }
+    if(settings.stream){
+        stream.release();
+    } else if(cloud.isOpen()){
+        cloudStreamer.release();
+        cloud.close();
+    } else if(VBO != 0){
+        glDeleteBuffers(1, &VBO);
+    }
+    if(EBO != 0){
+        glDeleteBuffers(1, &EBO);
+    }
     glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
     glDeleteProgram(shaderProgram);
 
     // terminate the window
@@ -167,55 +446,137 @@ int main(void)
     return 0;
 }
 
-void constructSierpinshi(int iterations, float vertices[]){
-    // picking an actual random initial point is hard so intial point is 0,0 for now
-    float Px = 0.0f;
-    float Py = 0.0f;
-    
-    // bounding triangle vertices
-    float v1x = -0.5f;
-    float v1y = -0.5f;
-    float v2x =  0.0f;
-    float v2y =  0.5f;
-    float v3x =  0.5f;
-    float v3y = -0.5f;
-    
-    // shoving bounding triangle in first three of buffer
-    vertices[0] = v1x;
-    vertices[1] = v1y;
-    vertices[2] = 0.0f; //z-coord
-    vertices[3] = v2x;
-    vertices[4] = v2y;
-    vertices[5] = 0.0f; //z-coord
-    vertices[6] = v3x;
-    vertices[7] = v3y;
-    vertices[8] = 0.0f; //z-coord
-
-    int vertex = 0;
-    int offset = 9; // offset to jump past bounding triangle
-    for(int i = 0; i < iterations; i++){
-        // choose random vertex of bounding triangle
-        vertex = (rand() % 3) + 1;
-        switch(vertex){
-            // find midpoint between working point and randomly chosen vertex
-            case 2:
-                Px = (Px + v2x)/2;
-                Py = (Py + v2y)/2;
-            break;
-            case 3:
-                Px = (Px + v3x)/2;
-                Py = (Py + v3y)/2;
-            break;
-            default:
-                Px = (Px + v1x)/2;
-                Py = (Py + v1y)/2;
+void benchmarkPointOrder(GLFWwindow *window, const GasketSettings &settings, unsigned int shaderProgram){
+    glfwSwapInterval(0); // vsync would hide the difference
+
+    const char *orderNames[2] = { "generated", "morton" };
+    double frameTimes[2] = { 0.0, 0.0 };
+    for(int order = 0; order < 2; order++){
+        std::vector<float> vertices(fractalFloatCount(settings.fractal, settings.iterations));
+        constructFractal(settings.fractal, settings.iterations, vertices.data(), settings.threads, settings.seed,
+                         settings.kernel, order == 1);
+        GLsizei pointCount = static_cast<GLsizei>(vertices.size() / 3);
+        packPoints(settings.format, vertices.data(), pointCount, vertices.data());
+
+        unsigned int VAO, VBO;
+        glGenVertexArrays(1, &VAO);
+        glBindVertexArray(VAO);
+        glGenBuffers(1, &VBO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, pointCount * pointFormatStride(settings.format), vertices.data(), GL_STATIC_DRAW);
+        setPointAttribute(settings.format);
+        glEnable(GL_PROGRAM_POINT_SIZE);
+
+        // GPU time of just the draw, read back every frame so frames never overlap
+        unsigned int query;
+        glGenQueries(1, &query);
+        for(int frame = 0; frame < BENCHMARK_WARMUP_FRAMES + BENCHMARK_FRAMES; frame++){
+            glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+
+            glBeginQuery(GL_TIME_ELAPSED, query);
+            glUseProgram(shaderProgram);
+            glDrawArrays(GL_POINTS, 0, pointCount);
+            glEndQuery(GL_TIME_ELAPSED);
+
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+            if(frame >= BENCHMARK_WARMUP_FRAMES){
+                frameTimes[order] += elapsed / 1.0e6;
+            }
+
+            glfwSwapBuffers(window);
+            glfwPollEvents();
         }
-        
-        // mark midpoint
-        vertices[(i * 3) + offset] = Px;
-        vertices[(i * 3) + 1 + offset] = Py;
-        vertices[(i * 3) + 2 + offset] = 0.0f; // staying 2D so z axis needs to be zero
+        frameTimes[order] /= BENCHMARK_FRAMES;
+        std::cout << "Benchmark: " << settings.iterations << " " << orderNames[order] << " order points take "
+                  << frameTimes[order] << " ms a frame" << std::endl;
+
+        glDeleteQueries(1, &query);
+        glDeleteBuffers(1, &VBO);
+        glDeleteVertexArrays(1, &VAO);
     }
+    std::cout << "Benchmark: morton order is " << frameTimes[0] / frameTimes[1] << "x the speed of generated order" << std::endl;
+}
 
+void processInput(GLFWwindow *window, int &level, GasketView &view, float deltaTime){
+    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
 
-}
\ No newline at end of file
+    // WASD pans a screen's worth every two seconds whatever the zoom, Q and E zoom 4x a second
+    const double panSpeed = 1.0 / view.zoom * deltaTime;
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS){
+        view.centerY += panSpeed;
+    }
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS){
+        view.centerY -= panSpeed;
+    }
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS){
+        view.centerX -= panSpeed;
+    }
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS){
+        view.centerX += panSpeed;
+    }
+    if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS){
+        view.zoom *= std::pow(4.0, deltaTime);
+    }
+    if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS){
+        view.zoom = std::max(view.zoom / std::pow(4.0, deltaTime), 0.25);
+    }
+
+    // up and down arrows step the level once per press
+    static bool upHeld = false;
+    static bool downHeld = false;
+    bool up = glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS;
+    bool down = glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS;
+    if(up && !upHeld && level < MAX_INSTANCED_LEVEL){
+        level++;
+    }
+    if(down && !downHeld && level > 0){
+        level--;
+    }
+    upHeld = up;
+    downHeld = down;
+}
+
+void processOrbitInput(GLFWwindow *window, OrbitCamera &camera, float deltaTime){
+    // A and D circle around, W and S go over and under (stopping short of straight up), Q and E move out and in
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS){
+        camera.yaw -= deltaTime;
+    }
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS){
+        camera.yaw += deltaTime;
+    }
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS){
+        camera.pitch = std::min(camera.pitch + deltaTime, 1.5f);
+    }
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS){
+        camera.pitch = std::max(camera.pitch - deltaTime, -1.5f);
+    }
+    if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS){
+        camera.distance = std::max(camera.distance / std::pow(2.0f, deltaTime), 0.05f);
+    }
+    if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS){
+        camera.distance *= std::pow(2.0f, deltaTime);
+    }
+}
+
+void setAnalyticView(unsigned int program, const GasketView &view){
+    // split each double into a float plus the float sized rest, the shader adds them back error free
+    float centerHi[2] = { static_cast<float>(view.centerX), static_cast<float>(view.centerY) };
+    float centerLo[2] = { static_cast<float>(view.centerX - centerHi[0]), static_cast<float>(view.centerY - centerHi[1]) };
+
+    // zoom 1 matches the other modes, the [-1, 1] screen stretched over the window
+    float pixelSize[2] = { static_cast<float>(2.0 / (SCR_WIDTH * view.zoom)), static_cast<float>(2.0 / (SCR_HEIGHT * view.zoom)) };
+
+    // fold until the remaining triangles are about a pixel tall, the real gasket has no area so going
+    // deeper than that would just sample holes
+    int levels = static_cast<int>(std::floor(std::log2(view.zoom * SCR_HEIGHT * 0.5)));
+    levels = std::max(1, std::min(levels, MAX_ANALYTIC_LEVELS));
+
+    glUniform2fv(glGetUniformLocation(program, "centerHi"), 1, centerHi);
+    glUniform2fv(glGetUniformLocation(program, "centerLo"), 1, centerLo);
+    glUniform2fv(glGetUniformLocation(program, "pixelSize"), 1, pixelSize);
+    glUniform2f(glGetUniformLocation(program, "screenCenter"), SCR_WIDTH * 0.5f, SCR_HEIGHT * 0.5f);
+    glUniform1i(glGetUniformLocation(program, "levels"), levels);
+}
@@ -0,0 +1,71 @@
+#ifndef GLSTATE_H
+#define GLSTATE_H
+
+#include <glad/glad.h>
+
+#include <unordered_map>
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+
+// how many calls went through to GL and how many were dropped because they wouldn't have changed anything
+struct GLStateCounters {
+    unsigned long long issued = 0;
+    unsigned long long skipped = 0;
+};
+
+// remembers the program, vertex array, buffer and texture bindings and every uniform value it last set,
+// and only calls GL when the new value is different. a render loop can then bind and set everything it needs
+// each frame without paying for the ones that are already in place.
+// it only knows about calls made through it: anything else that changes these has to put them back the way it
+// found them (like ShaderBatch and FrameUniformBuffer do) or call invalidate() afterwards
+class GLState
+{
+private:
+    // the value a single uniform was last set to, big enough for the largest type (mat4)
+    struct UniformValue {
+        unsigned char bytes[sizeof(glm::mat4)];
+    };
+
+    unsigned int program;
+    unsigned int vertexArray;
+    unsigned int activeTextureUnit;
+    std::unordered_map<GLenum, unsigned int> buffers;                 // by target
+    std::unordered_map<unsigned long long, unsigned int> textures;    // by unit and target
+    std::unordered_map<unsigned long long, UniformValue> uniformValues; // by program and location
+    GLStateCounters counted;
+
+    // true (and value remembered) if the uniform at location in shader's program doesn't already hold value
+    bool uniformChanged(const Shader &shader, int location, const void* value, size_t size);
+
+public:
+    GLState();
+
+    void useProgram(unsigned int id);
+    void use(const Shader &shader);
+    void bindVertexArray(unsigned int id);
+    void bindBuffer(GLenum target, unsigned int id);
+
+    // selects unit (0 for GL_TEXTURE0) only if texture isn't already bound there
+    void bindTexture(unsigned int unit, GLenum target, unsigned int id);
+
+    // same as Shader::set but skipped when the uniform already has value. shader's program is made current first
+    void set(const Shader &shader, UniformHandle<bool> handle, bool value);
+    void set(const Shader &shader, UniformHandle<int> handle, int value);
+    void set(const Shader &shader, UniformHandle<float> handle, float value);
+    void set(const Shader &shader, UniformHandle<glm::vec2> handle, const glm::vec2 &vec);
+    void set(const Shader &shader, UniformHandle<glm::vec3> handle, const glm::vec3 &vec);
+    void set(const Shader &shader, UniformHandle<glm::vec4> handle, const glm::vec4 &vec);
+    void set(const Shader &shader, UniformHandle<glm::mat2> handle, const glm::mat2 &mat);
+    void set(const Shader &shader, UniformHandle<glm::mat3> handle, const glm::mat3 &mat);
+    void set(const Shader &shader, UniformHandle<glm::mat4> handle, const glm::mat4 &mat);
+
+    // forgets everything so the next call of each kind goes through, needed after a program is replaced
+    // (the new one can get the old one's ID) or an object bound through this is deleted
+    void invalidate();
+
+    const GLStateCounters &counters() const;
+    void resetCounters();
+};
+
+#endif
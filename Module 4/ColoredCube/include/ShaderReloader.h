@@ -0,0 +1,65 @@
+#ifndef SHADERRELOADER_H
+#define SHADERRELOADER_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Shader.h"
+
+// rebuilds shaders while the program runs whenever their files are saved
+// a worker thread waits on inotify (or checks modification times where there isn't any), then compiles and links
+// on its own hidden window whose context shares objects with the main one, so the render loop never waits on the
+// compiler. finished programs sit in a queue until swapReady() puts them in at the start of a frame, and a
+// program that doesn't compile or link is thrown away so the old one keeps drawing
+class ShaderReloader
+{
+private:
+    struct WatchedShader {
+        Shader* shader;
+        std::string vertexPath;
+        std::string fragmentPath;
+        std::vector<std::string> defines;
+        std::vector<std::string> files; // both shader files and everything they include, as of the last build
+    };
+
+    struct ReadyProgram {
+        Shader* shader;
+        unsigned int program;
+    };
+
+    GLFWwindow* workerWindow;          // hidden, only there for its shared context
+    std::vector<WatchedShader> watched; // fixed once the worker starts
+    std::vector<ReadyProgram> ready;   // linked on the worker, waiting for the next frame
+    std::mutex readyMutex;
+    std::atomic<bool> running;
+    std::thread worker;
+
+    void watchFiles();
+    void rebuild(WatchedShader &entry);
+
+public:
+    // creates the worker's context, has to be called on the main thread while window's context is current
+    ShaderReloader(GLFWwindow* window);
+
+    // shaders have to be added before start(), defines has to be the permutation shader was built with.
+    // a change to a file either shader file includes rebuilds it too, as long as it's in a directory that
+    // was already being watched when start() was called
+    void watch(Shader &shader, const std::string &vertexPath, const std::string &fragmentPath,
+               const std::vector<std::string> &defines = {});
+    void start();
+
+    // swaps in every program that finished since the last call, true if anything changed so the caller can
+    // fetch its uniform handles again. never blocks on the worker
+    bool swapReady();
+
+    // stops the worker and deletes anything it built that never got swapped in
+    void release();
+};
+
+#endif
@@ -4,8 +4,7 @@ layout (location = 0) in vec3 aPos;
 out vec4 vertexPos;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#include "Frame.glsl"
 void main()
 {
     gl_Position = projection * view * model* vec4(aPos, 1.0);
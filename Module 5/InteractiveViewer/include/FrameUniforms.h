@@ -0,0 +1,54 @@
+#ifndef FRAMEUNIFORMS_H
+#define FRAMEUNIFORMS_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <glm/glm.hpp>
+
+// binding point the Frame block of every program is attached to
+const unsigned int FRAME_UNIFORM_BINDING = 0;
+
+// data that is the same for every program in a frame, mirrors this block in the shaders:
+//
+//     layout (std140) uniform Frame
+//     {
+//         mat4 view;
+//         mat4 projection;
+//         vec4 cameraPosition;
+//         float time;
+//     };
+//
+// std140 rounds vec3s up to 16 bytes, so the camera goes in a vec4 and the block ends padded out to a vec4
+struct FrameUniforms {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec4 cameraPosition; // w is unused
+    float time;
+    float padding[3];
+};
+
+// offsets std140 gives the block above, a mismatch here means the shaders would read garbage
+static_assert(sizeof(glm::mat4) == 64 && sizeof(glm::vec4) == 16, "glm types have to be tightly packed floats");
+static_assert(offsetof(FrameUniforms, view) == 0, "Frame.view has to be at offset 0");
+static_assert(offsetof(FrameUniforms, projection) == 64, "Frame.projection has to be at offset 64");
+static_assert(offsetof(FrameUniforms, cameraPosition) == 128, "Frame.cameraPosition has to be at offset 128");
+static_assert(offsetof(FrameUniforms, time) == 144, "Frame.time has to be at offset 144");
+static_assert(sizeof(FrameUniforms) == 160, "Frame has to be padded to a multiple of 16 bytes");
+
+// one uniform buffer holding FrameUniforms, bound to FRAME_UNIFORM_BINDING for the life of the program
+// filling it once a frame replaces setting view and projection on every program separately
+class FrameUniformBuffer
+{
+private:
+    unsigned int UBO;
+
+public:
+    FrameUniformBuffer();
+
+    void update(const FrameUniforms &frame);
+
+    void release();
+};
+
+#endif
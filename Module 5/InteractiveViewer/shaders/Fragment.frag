@@ -11,6 +11,10 @@ uniform sampler2D texture1;
 
 void main()
 {
+    // TEXTURED is defined by the program that asks for this permutation, without it the cube is colored by position
+#ifdef TEXTURED
     FragColor = texture(texture1, TexCoord);
-    // FragColor = vec4(vertexPos.x + 0.5, vertexPos.y + 0.5, vertexPos.z + 0.5, 1.0);
+#else
+    FragColor = vec4(vertexPos.x + 0.5, vertexPos.y + 0.5, vertexPos.z + 0.5, 1.0);
+#endif
 }
\ No newline at end of file
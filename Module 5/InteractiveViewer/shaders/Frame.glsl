@@ -0,0 +1,9 @@
+// per frame data shared by every program, filled once a frame (FrameUniforms on the C++ side)
+// pulled into a shader with #include "Frame.glsl", see Shader::preprocess
+layout (std140) uniform Frame
+{
+    mat4 view;
+    mat4 projection;
+    vec4 cameraPosition;
+    float time;
+};
@@ -7,8 +7,7 @@ out vec4 vertexPos;
 out vec2 TexCoord;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#include "Frame.glsl"
 
 void main()
 {
@@ -0,0 +1,150 @@
+#include "ShaderBatch.h"
+
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+
+// from GL_KHR_parallel_shader_compile, glad was generated without extensions so it's loaded by hand
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+typedef void (APIENTRY *MaxShaderCompilerThreadsProc)(GLuint count);
+
+ShaderBatch::ShaderBatch(){
+    parallel = glfwExtensionSupported("GL_KHR_parallel_shader_compile") == GLFW_TRUE;
+    if(parallel){
+        // the most it allows, the driver picks the real number
+        MaxShaderCompilerThreadsProc maxShaderCompilerThreads =
+            reinterpret_cast<MaxShaderCompilerThreadsProc>(glfwGetProcAddress("glMaxShaderCompilerThreadsKHR"));
+        if(maxShaderCompilerThreads != NULL){
+            maxShaderCompilerThreads(0xFFFFFFFF);
+        }
+    }
+}
+
+size_t ShaderBatch::add(const char* vertexPath, const char* fragmentPath, const std::vector<std::string> &defines){
+    // asking for a permutation the batch already has shares its program instead of compiling it twice
+    std::string key = std::string(vertexPath) + "|" + fragmentPath + "|" + Shader::permutationKey(defines);
+    for(size_t i = 0; i < jobs.size(); i++){
+        if(jobs[i].key == key){
+            order.push_back(i);
+            return order.size() - 1;
+        }
+    }
+
+    Job job;
+    job.key = key;
+    if(!Shader::loadSource(vertexPath, defines, job.vertexCode) || !Shader::loadSource(fragmentPath, defines, job.fragmentCode)){
+        std::cout << "ERROR: SHADER FILES WERE NOT READ" << std::endl;
+    }
+    jobs.push_back(job);
+    order.push_back(jobs.size() - 1);
+    return order.size() - 1;
+}
+
+size_t ShaderBatch::add(const std::string &vertexName, const std::string &fragmentName, const std::vector<EmbeddedAsset> &embedded,
+                        const std::vector<std::string> &defines){
+    std::string key = "embedded|" + vertexName + "|" + fragmentName + "|" + Shader::permutationKey(defines);
+    for(size_t i = 0; i < jobs.size(); i++){
+        if(jobs[i].key == key){
+            order.push_back(i);
+            return order.size() - 1;
+        }
+    }
+
+    Job job;
+    job.key = key;
+    if(!Shader::loadSource(vertexName, embedded, defines, job.vertexCode)
+       || !Shader::loadSource(fragmentName, embedded, defines, job.fragmentCode)){
+        std::cout << "ERROR: SHADER " << vertexName << " OR " << fragmentName << " WAS NOT EMBEDDED" << std::endl;
+    }
+    jobs.push_back(job);
+    order.push_back(jobs.size() - 1);
+    return order.size() - 1;
+}
+
+void ShaderBatch::submit(){
+    // compiles first and links after, a link right behind its own compile would wait on it in some drivers
+    for(Job &job : jobs){
+        job.cachePath = Shader::binaryCachePath(job.vertexCode, job.fragmentCode);
+        job.fromCache = Shader::loadProgramBinary(job.cachePath, job.program);
+        if(!job.fromCache){
+            job.vertexShader = Shader::startCompile(GL_VERTEX_SHADER, job.vertexCode);
+            job.fragmentShader = Shader::startCompile(GL_FRAGMENT_SHADER, job.fragmentCode);
+        }
+    }
+    for(Job &job : jobs){
+        if(!job.fromCache){
+            job.program = Shader::startLink(job.vertexShader, job.fragmentShader);
+        }
+    }
+}
+
+bool ShaderBatch::ready() const{
+    if(!parallel){
+        return true;
+    }
+    for(const Job &job : jobs){
+        int complete = GL_TRUE;
+        if(!job.fromCache){
+            glGetProgramiv(job.program, GL_COMPLETION_STATUS_KHR, &complete);
+        }
+        if(!complete){
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<Shader> ShaderBatch::collect(unsigned int vertexArray){
+    std::vector<Shader> built;
+    for(Job &job : jobs){
+        if(!job.fromCache){
+            // & rather than && so every log gets printed
+            bool success = Shader::checkCompile(job.vertexShader, GL_VERTEX_SHADER)
+                           & Shader::checkCompile(job.fragmentShader, GL_FRAGMENT_SHADER) & Shader::checkLink(job.program);
+            glDeleteShader(job.vertexShader);
+            glDeleteShader(job.fragmentShader);
+            if(success){
+                Shader::saveProgramBinary(job.cachePath, job.program);
+            }
+        }
+        built.push_back(Shader(job.program));
+    }
+    warmUp(built, vertexArray);
+
+    std::vector<Shader> shaders;
+    for(size_t job : order){
+        shaders.push_back(built[job]);
+    }
+    jobs.clear();
+    order.clear();
+    return shaders;
+}
+
+void ShaderBatch::warmUp(const std::vector<Shader> &shaders, unsigned int vertexArray) const{
+    int previousProgram, previousVAO;
+    int previousScissor[4];
+    glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &previousVAO);
+    glGetIntegerv(GL_SCISSOR_BOX, previousScissor);
+    bool scissorWasOn = glIsEnabled(GL_SCISSOR_TEST) == GL_TRUE;
+
+    // the real vertex layout, framebuffer and every other bit of state drivers build shader variants for,
+    // an empty scissor box keeps the draws from touching a single pixel of the window
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(0, 0, 0, 0);
+    glBindVertexArray(vertexArray);
+    for(const Shader &shader : shaders){
+        glUseProgram(shader.ID);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+    // waiting here is the point, the first real frame shouldn't have to
+    glFinish();
+
+    glBindVertexArray(previousVAO);
+    glUseProgram(previousProgram);
+    glScissor(previousScissor[0], previousScissor[1], previousScissor[2], previousScissor[3]);
+    if(!scissorWasOn){
+        glDisable(GL_SCISSOR_TEST);
+    }
+}
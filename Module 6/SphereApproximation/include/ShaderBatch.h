@@ -0,0 +1,62 @@
+#ifndef SHADERBATCH_H
+#define SHADERBATCH_H
+
+#include <glad/glad.h>
+
+#include <string>
+#include <vector>
+
+#include "Shader.h"
+
+// builds several programs together instead of one after another like the Shader constructor does
+// every compile and link is started before any status is asked for, so the driver can work on them side by side
+// (on its own threads where GL_KHR_parallel_shader_compile is supported) while the caller sets up everything else.
+// each finished program is then drawn once with the caller's vertex array into the window's own framebuffer, with
+// nothing let through the scissor, so work drivers put off until the first draw for that state happens here
+// rather than as a hitch in the first real frame
+class ShaderBatch
+{
+private:
+    struct Job {
+        std::string key;     // files and permutation, two adds with the same key share a program
+        std::string cachePath;
+        std::string vertexCode;
+        std::string fragmentCode;
+        unsigned int vertexShader = 0;
+        unsigned int fragmentShader = 0;
+        unsigned int program = 0;
+        bool fromCache = false;
+    };
+
+    std::vector<Job> jobs;
+    std::vector<size_t> order; // job each add() call got, collect() hands them back in this order
+    bool parallel; // driver compiles on its own threads and can say when it's done without blocking
+
+    void warmUp(const std::vector<Shader> &shaders, unsigned int vertexArray) const;
+
+public:
+    ShaderBatch();
+
+    // reads and preprocesses the sources with defines (see Shader::preprocess), nothing is handed to GL until
+    // submit(). returns where the program will be in collect()'s result
+    size_t add(const char* vertexPath, const char* fragmentPath, const std::vector<std::string> &defines = {});
+
+    // same for shaders compiled into the executable, see the matching Shader constructor
+    size_t add(const std::string &vertexName, const std::string &fragmentName, const std::vector<EmbeddedAsset> &embedded,
+               const std::vector<std::string> &defines = {});
+
+    // starts every program, from the binary cache when possible, and returns without waiting for any of them
+    void submit();
+
+    // true once every program has finished compiling and linking. never blocks when the driver compiles in
+    // parallel, so the caller can keep handling window events until it's true. otherwise there's no way to ask
+    // without waiting so it always says true, and collect() does the waiting
+    bool ready() const;
+
+    // waits for whatever is left, prints any errors, warms every program up by drawing vertexArray with the
+    // current GL state and framebuffer, and returns them in the order they were added. everything the real draw
+    // depends on (vertex array, Frame uniform buffer, textures, depth test) should be set up before this is called
+    std::vector<Shader> collect(unsigned int vertexArray);
+};
+
+#endif
@@ -0,0 +1,160 @@
+#include "GLState.h"
+
+#include <cstring>
+
+// what a binding is treated as until this has set it, never a real GL name
+static const unsigned int UNKNOWN = 0xFFFFFFFF;
+
+static unsigned long long pairKey(unsigned int high, unsigned int low){
+    return (static_cast<unsigned long long>(high) << 32) | low;
+}
+
+GLState::GLState(){
+    invalidate();
+}
+
+void GLState::useProgram(unsigned int id){
+    if(program == id){
+        counted.skipped++;
+        return;
+    }
+    glUseProgram(id);
+    program = id;
+    counted.issued++;
+}
+
+void GLState::use(const Shader &shader){
+    useProgram(shader.ID);
+}
+
+void GLState::bindVertexArray(unsigned int id){
+    if(vertexArray == id){
+        counted.skipped++;
+        return;
+    }
+    glBindVertexArray(id);
+    vertexArray = id;
+    // the element buffer binding belongs to the vertex array, so it changed along with it
+    buffers.erase(GL_ELEMENT_ARRAY_BUFFER);
+    counted.issued++;
+}
+
+void GLState::bindBuffer(GLenum target, unsigned int id){
+    auto bound = buffers.find(target);
+    if(bound != buffers.end() && bound->second == id){
+        counted.skipped++;
+        return;
+    }
+    glBindBuffer(target, id);
+    buffers[target] = id;
+    counted.issued++;
+}
+
+void GLState::bindTexture(unsigned int unit, GLenum target, unsigned int id){
+    unsigned long long key = pairKey(unit, target);
+    auto bound = textures.find(key);
+    if(bound != textures.end() && bound->second == id){
+        counted.skipped++;
+        return;
+    }
+    if(activeTextureUnit != unit){
+        glActiveTexture(GL_TEXTURE0 + unit);
+        activeTextureUnit = unit;
+        counted.issued++;
+    }
+    glBindTexture(target, id);
+    textures[key] = id;
+    counted.issued++;
+}
+
+bool GLState::uniformChanged(const Shader &shader, int location, const void* value, size_t size){
+    // GL ignores -1, so there's nothing to send
+    if(location < 0){
+        counted.skipped++;
+        return false;
+    }
+    // uniform values stay with their program, switching programs and back doesn't lose them
+    unsigned long long key = pairKey(shader.ID, static_cast<unsigned int>(location));
+    auto last = uniformValues.find(key);
+    if(last != uniformValues.end() && std::memcmp(last->second.bytes, value, size) == 0){
+        counted.skipped++;
+        return false;
+    }
+    std::memcpy(uniformValues[key].bytes, value, size);
+    useProgram(shader.ID);
+    counted.issued++;
+    return true;
+}
+
+void GLState::set(const Shader &shader, UniformHandle<bool> handle, bool value){
+    // stored the way it's uploaded, as an int
+    int asInt = (int)value;
+    if(uniformChanged(shader, handle.location, &asInt, sizeof(asInt))){
+        shader.set(handle, value);
+    }
+}
+
+void GLState::set(const Shader &shader, UniformHandle<int> handle, int value){
+    if(uniformChanged(shader, handle.location, &value, sizeof(value))){
+        shader.set(handle, value);
+    }
+}
+
+void GLState::set(const Shader &shader, UniformHandle<float> handle, float value){
+    if(uniformChanged(shader, handle.location, &value, sizeof(value))){
+        shader.set(handle, value);
+    }
+}
+
+void GLState::set(const Shader &shader, UniformHandle<glm::vec2> handle, const glm::vec2 &vec){
+    if(uniformChanged(shader, handle.location, &vec[0], sizeof(vec))){
+        shader.set(handle, vec);
+    }
+}
+
+void GLState::set(const Shader &shader, UniformHandle<glm::vec3> handle, const glm::vec3 &vec){
+    if(uniformChanged(shader, handle.location, &vec[0], sizeof(vec))){
+        shader.set(handle, vec);
+    }
+}
+
+void GLState::set(const Shader &shader, UniformHandle<glm::vec4> handle, const glm::vec4 &vec){
+    if(uniformChanged(shader, handle.location, &vec[0], sizeof(vec))){
+        shader.set(handle, vec);
+    }
+}
+
+void GLState::set(const Shader &shader, UniformHandle<glm::mat2> handle, const glm::mat2 &mat){
+    if(uniformChanged(shader, handle.location, &mat[0][0], sizeof(mat))){
+        shader.set(handle, mat);
+    }
+}
+
+void GLState::set(const Shader &shader, UniformHandle<glm::mat3> handle, const glm::mat3 &mat){
+    if(uniformChanged(shader, handle.location, &mat[0][0], sizeof(mat))){
+        shader.set(handle, mat);
+    }
+}
+
+void GLState::set(const Shader &shader, UniformHandle<glm::mat4> handle, const glm::mat4 &mat){
+    if(uniformChanged(shader, handle.location, &mat[0][0], sizeof(mat))){
+        shader.set(handle, mat);
+    }
+}
+
+void GLState::invalidate(){
+    program = UNKNOWN;
+    vertexArray = UNKNOWN;
+    activeTextureUnit = UNKNOWN;
+    buffers.clear();
+    textures.clear();
+    uniformValues.clear();
+}
+
+const GLStateCounters &GLState::counters() const{
+    return counted;
+}
+
+void GLState::resetCounters(){
+    counted = GLStateCounters();
+}
@@ -0,0 +1,224 @@
+#include "ShaderReloader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// how long the worker sleeps between checks, also how long release() can wait for it
+static const int WATCH_INTERVAL_MS = 200;
+// editors tend to save in a few steps (truncate, write, rename), so a change is only read once they've settled
+static const int SETTLE_MS = 50;
+
+static std::string directoryOf(const std::string &path){
+    std::string directory = std::filesystem::path(path).parent_path().string();
+    return directory.empty() ? "." : directory;
+}
+
+static std::string fileNameOf(const std::string &path){
+    return std::filesystem::path(path).filename().string();
+}
+
+ShaderReloader::ShaderReloader(GLFWwindow* window) : running(false){
+    // the worker gets a context of its own that shares programs with window's, it never shows up on screen
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    workerWindow = glfwCreateWindow(1, 1, "Shader Compiler", NULL, window);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+    if(workerWindow == NULL){
+        std::cout << "ERROR: COULD NOT CREATE THE SHADER RELOAD CONTEXT, SHADERS WILL NOT RELOAD" << std::endl;
+    }
+}
+
+void ShaderReloader::watch(Shader &shader, const std::string &vertexPath, const std::string &fragmentPath,
+                           const std::vector<std::string> &defines){
+    // preprocessing once finds the includes, the source itself isn't needed until something changes
+    WatchedShader entry = { &shader, vertexPath, fragmentPath, defines, {} };
+    std::string code;
+    Shader::loadSource(vertexPath, defines, code, &entry.files);
+    Shader::loadSource(fragmentPath, defines, code, &entry.files);
+    if(entry.files.empty()){
+        entry.files = { vertexPath, fragmentPath };
+    }
+    watched.push_back(entry);
+}
+
+void ShaderReloader::start(){
+    if(workerWindow == NULL || watched.empty()){
+        return;
+    }
+    running = true;
+    worker = std::thread([this](){
+        glfwMakeContextCurrent(workerWindow);
+        watchFiles();
+        glfwMakeContextCurrent(NULL);
+    });
+}
+
+void ShaderReloader::watchFiles(){
+#ifdef __linux__
+    // directories are watched rather than the files, saving by renaming a new file over the old one would
+    // otherwise end the watch after the first save
+    int notify = inotify_init1(IN_NONBLOCK);
+    std::vector<std::pair<int, std::string>> directories;
+    if(notify >= 0){
+        for(const WatchedShader &entry : watched){
+            for(const std::string &path : entry.files){
+                std::string directory = directoryOf(path);
+                bool known = false;
+                for(const auto &watchedDirectory : directories){
+                    known = known || watchedDirectory.second == directory;
+                }
+                if(!known){
+                    int descriptor = inotify_add_watch(notify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+                    if(descriptor >= 0){
+                        directories.push_back({ descriptor, directory });
+                    }
+                }
+            }
+        }
+    }
+
+    if(notify >= 0 && !directories.empty()){
+        std::vector<bool> changed(watched.size());
+        alignas(inotify_event) char buffer[4096];
+        while(running){
+            pollfd waiting = { notify, POLLIN, 0 };
+            if(poll(&waiting, 1, WATCH_INTERVAL_MS) <= 0){
+                continue;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(SETTLE_MS));
+
+            // marks every shader one of the saved files belongs to
+            std::fill(changed.begin(), changed.end(), false);
+            ssize_t length;
+            while((length = read(notify, buffer, sizeof(buffer))) > 0){
+                for(char* next = buffer; next < buffer + length; ){
+                    const inotify_event* event = reinterpret_cast<const inotify_event*>(next);
+                    next += sizeof(inotify_event) + event->len;
+                    if(event->len == 0){
+                        continue;
+                    }
+                    std::string directory;
+                    for(const auto &watchedDirectory : directories){
+                        if(watchedDirectory.first == event->wd){
+                            directory = watchedDirectory.second;
+                        }
+                    }
+                    std::string name(event->name);
+                    for(size_t i = 0; i < watched.size(); i++){
+                        for(const std::string &path : watched[i].files){
+                            if(directoryOf(path) == directory && fileNameOf(path) == name){
+                                changed[i] = true;
+                            }
+                        }
+                    }
+                }
+            }
+
+            for(size_t i = 0; i < watched.size(); i++){
+                if(changed[i]){
+                    rebuild(watched[i]);
+                }
+            }
+        }
+        close(notify);
+        return;
+    }
+    if(notify >= 0){
+        close(notify);
+    }
+    std::cout << "WARNING: INOTIFY IS NOT AVAILABLE, CHECKING THE SHADER FILES FOR CHANGES INSTEAD" << std::endl;
+#endif
+
+    // everywhere else the modification times are compared every interval
+    auto writeTime = [](const std::string &path){
+        std::error_code error;
+        std::filesystem::file_time_type time = std::filesystem::last_write_time(path, error);
+        return error ? std::filesystem::file_time_type::min() : time;
+    };
+    auto writeTimes = [&writeTime](const WatchedShader &entry){
+        std::vector<std::filesystem::file_time_type> times;
+        for(const std::string &path : entry.files){
+            times.push_back(writeTime(path));
+        }
+        return times;
+    };
+    std::vector<std::vector<std::filesystem::file_time_type>> lastWrite;
+    for(const WatchedShader &entry : watched){
+        lastWrite.push_back(writeTimes(entry));
+    }
+    while(running){
+        std::this_thread::sleep_for(std::chrono::milliseconds(WATCH_INTERVAL_MS));
+        for(size_t i = 0; i < watched.size(); i++){
+            if(writeTimes(watched[i]) != lastWrite[i]){
+                std::this_thread::sleep_for(std::chrono::milliseconds(SETTLE_MS));
+                rebuild(watched[i]);
+                // the rebuild can add or drop includes
+                lastWrite[i] = writeTimes(watched[i]);
+            }
+        }
+    }
+}
+
+void ShaderReloader::rebuild(WatchedShader &entry){
+    std::string vertexCode;
+    std::string fragmentCode;
+    std::vector<std::string> files;
+    if(!Shader::loadSource(entry.vertexPath, entry.defines, vertexCode, &files)
+       || !Shader::loadSource(entry.fragmentPath, entry.defines, fragmentCode, &files)){
+        std::cout << "WARNING: SHADER FILES COULD NOT BE READ FOR RELOADING, KEEPING THE OLD PROGRAM" << std::endl;
+        return;
+    }
+
+    entry.files = files;
+
+    unsigned int program = 0;
+    if(!Shader::buildProgram(vertexCode, fragmentCode, program)){
+        glDeleteProgram(program);
+        std::cout << "WARNING: KEEPING THE OLD PROGRAM FOR " << entry.vertexPath << std::endl;
+        return;
+    }
+
+    // the link has to have really finished before another context can use the program
+    glFinish();
+    std::lock_guard<std::mutex> lock(readyMutex);
+    ready.push_back({ entry.shader, program });
+}
+
+bool ShaderReloader::swapReady(){
+    // the worker only holds the lock to push, if it has it right now the program goes in next frame
+    std::vector<ReadyProgram> swapping;
+    {
+        std::unique_lock<std::mutex> lock(readyMutex, std::try_to_lock);
+        if(!lock.owns_lock() || ready.empty()){
+            return false;
+        }
+        swapping.swap(ready);
+    }
+    for(const ReadyProgram &finished : swapping){
+        finished.shader->replaceProgram(finished.program);
+    }
+    std::cout << "Reloaded " << swapping.size() << " shader program(s)" << std::endl;
+    return true;
+}
+
+void ShaderReloader::release(){
+    running = false;
+    if(worker.joinable()){
+        worker.join();
+    }
+    for(const ReadyProgram &finished : ready){
+        glDeleteProgram(finished.program);
+    }
+    ready.clear();
+    if(workerWindow != NULL){
+        glfwDestroyWindow(workerWindow);
+        workerWindow = NULL;
+    }
+}
@@ -17,6 +17,11 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include "Shader.h"
+#include "FrameUniforms.h"
+#include "ShaderReloader.h"
+#include "ShaderBatch.h"
+#include "GLState.h"
+#include "EmbeddedAssets.h"
 #include "Sphere.h"
 
 
@@ -29,8 +34,6 @@ const unsigned int SCR_WIDTH = 1440;
 const unsigned int SCR_HEIGHT = 1080;
 const unsigned int STRIDE = 3;
 
-//const std::string PROJECT_DIRECTORY = std::filesystem::current_path().string();
-const std::string PROJECT_DIRECTORY = "C:\\Users\\Shawn\\OneDrive\\Documents\\CSUGlobal\\CSC405\\Module 4\\ColoredCube" ;
 
 int main(void)
 {
@@ -62,10 +65,11 @@ int main(void)
         return -1;
     }
 
-    // Creating and building shaders
-    std::string VertexPath = PROJECT_DIRECTORY + "\\shaders\\Vertex.vert";
-    std::string FragmentPath = PROJECT_DIRECTORY + "\\shaders\\Fragment.frag";
-    Shader CubeShader(VertexPath.c_str(),FragmentPath.c_str()); //takes in c-style strings
+    // Creating and building shaders, from the copies compiled into the executable so it runs from any directory
+    // the driver compiles these while the rest gets set up, they're collected right before drawing starts
+    ShaderBatch shaderBatch;
+    shaderBatch.add("Vertex.vert", "Fragment.frag", EMBEDDED_ASSETS);
+    shaderBatch.submit();
 
     // enabling depth test
     glEnable(GL_DEPTH_TEST);
@@ -100,7 +104,31 @@ int main(void)
     // enabling point size to be changed by vertex renderer
     glEnable(GL_PROGRAM_POINT_SIZE);
 
-    CubeShader.activate();
+    // view and projection reach every program through one buffer, see FrameUniforms.h
+    FrameUniformBuffer frameUniforms;
+
+    // the window keeps handling events while the driver finishes compiling, then each program gets warmed up
+    // by drawing VAO with the state set above
+    while(!shaderBatch.ready()){
+        glfwWaitEventsTimeout(0.001);
+    }
+    std::vector<Shader> shaders = shaderBatch.collect(VAO);
+    Shader &CubeShader = shaders[0];
+
+    // resolving the uniforms once, the render loop then sets them without any name lookups
+    UniformHandle<glm::vec4> boxColorUniform = CubeShader.uniform<glm::vec4>("boxColor");
+    UniformHandle<glm::mat4> modelUniform = CubeShader.uniform<glm::mat4>("model");
+
+    // saving either shader file in the source tree rebuilds the program in the background while this keeps drawing
+    std::string VertexPath = std::string(SHADER_SOURCE_DIRECTORY) + "/Vertex.vert";
+    std::string FragmentPath = std::string(SHADER_SOURCE_DIRECTORY) + "/Fragment.frag";
+    ShaderReloader shaderReloader(window);
+    shaderReloader.watch(CubeShader, VertexPath, FragmentPath);
+    shaderReloader.start();
+
+    // binds and uniform uploads in the render loop go through this, so the ones that wouldn't change anything
+    // are skipped instead of reaching the driver every frame
+    GLState glState;
 
     // glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
     /* rendering time baby!*/
@@ -108,12 +136,21 @@ int main(void)
     {
         // input
         processInput(window);
+
+        // a rebuilt program only goes in here, between frames, and its uniforms are looked up again
+        if(shaderReloader.swapReady()){
+            boxColorUniform = CubeShader.uniform<glm::vec4>("boxColor");
+            modelUniform = CubeShader.uniform<glm::mat4>("model");
+            // the new program can have the old one's ID, so nothing remembered about it still holds
+            glState.invalidate();
+        }
+
         // Black Background
         glClearColor(0.0f, 0.12f, 0.23f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // Activate shader
-        CubeShader.activate();
+        glState.use(CubeShader);
         
         //----------------render the box
 
@@ -124,19 +161,24 @@ int main(void)
 
         // set box color
         glm::vec4 boxColor = glm::vec4(0.35f, 0.0f, 0.5f, 1.0f);
-        CubeShader.setVec4("boxColor", boxColor);
+        glState.set(CubeShader, boxColorUniform, boxColor);
         
         model = glm::rotate(model, (float)glfwGetTime(), glm::vec3(1.0f, 1.0f, 0.0f));
         view  = glm::translate(view, glm::vec3(0.0f, 0.0f, -3.0f));
         projection = glm::perspective(glm::radians(45.0f), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
 
-        // pass them to the shaders (3 different ways)
-        CubeShader.setMat4("model", model);
-        CubeShader.setMat4("view", view);
-        CubeShader.setMat4("projection", projection);
+        // camera for the whole frame goes in one buffer update, only the model matrix is per program
+        FrameUniforms frame = {};
+        frame.view = view;
+        frame.projection = projection;
+        frame.cameraPosition = glm::vec4(0.0f, 0.0f, 3.0f, 1.0f);
+        frame.time = (float)glfwGetTime();
+        frameUniforms.update(frame);
+
+        glState.set(CubeShader, modelUniform, model);
 
         // render box
-        glBindVertexArray(VAO);
+        glState.bindVertexArray(VAO);
         glDrawArrays(GL_TRIANGLES, 0, sizeof(vertices) / (sizeof(float) * STRIDE));
 
         /* Swap front and back buffers */
@@ -146,9 +188,15 @@ int main(void)
         glfwPollEvents();
     }
 
+    // how much the state tracking saved over the whole run
+    const GLStateCounters &stateCounters = glState.counters();
+    std::cout << "GL state calls: " << stateCounters.issued << " issued, " << stateCounters.skipped << " skipped" << std::endl;
+
     // Clean up
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
+    frameUniforms.release();
+    shaderReloader.release();
 
     // terminate the window
     glfwTerminate();
@@ -0,0 +1,38 @@
+# writes every file in ASSETS into a header as a constexpr byte array, so the executable doesn't have to find them at runtime
+# run as a script: cmake -DOUTPUT=<header> -DASSET_ROOT=<directory names are relative to> -DASSETS=<a|b|c> -P EmbedAssets.cmake
+# (the list is | separated, a ; wouldn't survive being passed on the command line)
+
+string(REPLACE "|" ";" ASSETS "${ASSETS}")
+set(PREVIOUS "")
+
+set(ARRAYS "")
+set(TABLE "")
+foreach(ASSET IN LISTS ASSETS)
+    get_filename_component(ASSET_PATH "${ASSET}" ABSOLUTE)
+    file(RELATIVE_PATH ASSET_NAME "${ASSET_ROOT}" "${ASSET_PATH}")
+    string(MAKE_C_IDENTIFIER "ASSET_${ASSET_NAME}" ARRAY_NAME)
+
+    # 16 bytes a line, then every byte as 0x.., and a 0 on the end so text can be used as a C string
+    file(READ "${ASSET_PATH}" HEX HEX)
+    string(REPEAT "[0-9a-f]" 32 LINE_OF_HEX)
+    string(REGEX REPLACE "(${LINE_OF_HEX})" "\\1\n    " HEX "${HEX}")
+    string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1, " HEX "${HEX}")
+    string(REPLACE ", \n" ",\n" HEX "${HEX}")
+
+    string(APPEND ARRAYS "// ${ASSET_NAME}\nconstexpr unsigned char ${ARRAY_NAME}[] = {\n    ${HEX}0x00\n};\n\n")
+    string(APPEND TABLE "    { \"${ASSET_NAME}\", ${ARRAY_NAME}, sizeof(${ARRAY_NAME}) - 1 },\n")
+endforeach()
+
+set(CONTENTS "// generated by cmake/EmbedAssets.cmake from the files under ${ASSET_ROOT}, edit those instead\n")
+string(APPEND CONTENTS "#ifndef EMBEDDEDASSETS_H\n#define EMBEDDEDASSETS_H\n\n#include \"EmbeddedAsset.h\"\n\n")
+string(APPEND CONTENTS "${ARRAYS}")
+string(APPEND CONTENTS "// every embedded file, looked up by name with findEmbeddedAsset\n")
+string(APPEND CONTENTS "const std::vector<EmbeddedAsset> EMBEDDED_ASSETS = {\n${TABLE}};\n\n#endif\n")
+
+# only touched when something changed, so the sources including it don't rebuild every time
+if(EXISTS "${OUTPUT}")
+    file(READ "${OUTPUT}" PREVIOUS)
+endif()
+if(NOT "${PREVIOUS}" STREQUAL "${CONTENTS}")
+    file(WRITE "${OUTPUT}" "${CONTENTS}")
+endif()
@@ -7,18 +7,131 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <unordered_map>
+#include <vector>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "EmbeddedAsset.h"
+
+// what glGetActiveUniform reported for one uniform after linking
+struct UniformInfo {
+    int location;
+    GLenum type;
+    int size; // array length, 1 for plain uniforms
+};
+
+// GL type each C++ value is uploaded as, the debug check compares it against what the program declared
+template <typename T> struct UniformType;
+template <> struct UniformType<bool>      { static constexpr GLenum VALUE = GL_BOOL; };
+template <> struct UniformType<int>       { static constexpr GLenum VALUE = GL_INT; };
+template <> struct UniformType<float>     { static constexpr GLenum VALUE = GL_FLOAT; };
+template <> struct UniformType<glm::vec2> { static constexpr GLenum VALUE = GL_FLOAT_VEC2; };
+template <> struct UniformType<glm::vec3> { static constexpr GLenum VALUE = GL_FLOAT_VEC3; };
+template <> struct UniformType<glm::vec4> { static constexpr GLenum VALUE = GL_FLOAT_VEC4; };
+template <> struct UniformType<glm::mat2> { static constexpr GLenum VALUE = GL_FLOAT_MAT2; };
+template <> struct UniformType<glm::mat3> { static constexpr GLenum VALUE = GL_FLOAT_MAT3; };
+template <> struct UniformType<glm::mat4> { static constexpr GLenum VALUE = GL_FLOAT_MAT4; };
+
+// a uniform's location looked up once at setup, setting through it is a single glUniform call
+// T is the C++ type it gets set with, so setting the wrong kind of value doesn't compile
+template <typename T>
+struct UniformHandle {
+    int location = -1; // -1 (not in the program) is ignored by GL like an unknown name is
+};
+
 class Shader
 {
+private:
+    std::unordered_map<std::string, UniformInfo> uniforms; // every active uniform, filled in right after linking
+
+    void reflectUniforms();
+    int findUniform(const std::string &name, GLenum type) const;
+
+    // everything a freshly linked ID needs before it's used: the uniform table and the Frame block binding
+    void prepareProgram();
+
+    // builds program from GLSL, false (with the log printed) if it didn't compile or link
+    static bool compileProgram(const std::string &vertexCode, const std::string &fragmentCode, unsigned int &program);
+
+    // the steps of compileProgram, split so a ShaderBatch can start every program before checking any of them
+    static unsigned int startCompile(GLenum stage, const std::string &code);
+    static bool checkCompile(unsigned int shader, GLenum stage);
+    static unsigned int startLink(unsigned int vertexShader, unsigned int fragmentShader);
+    static bool checkLink(unsigned int program);
+
+    // takes over a program that's already linked, see ShaderBatch
+    explicit Shader(unsigned int program);
+
+    friend class ShaderBatch;
+
+    // program binary cache, one file per set of sources and driver in the user's cache directory
+    static std::string binaryCachePath(const std::string &vertexCode, const std::string &fragmentCode);
+    static bool loadProgramBinary(const std::string &cachePath, unsigned int &program);
+    static void saveProgramBinary(const std::string &cachePath, unsigned int program);
+
 public:
     unsigned int ID;
     Shader(const char* vertexPath, const char* fragmentPath);
 
+    // one permutation of the shader files, each entry of defines ("NAME" or "NAME value") is #defined in both
+    Shader(const char* vertexPath, const char* fragmentPath, const std::vector<std::string> &defines);
+
+    // same but from files compiled into the executable (see cmake/EmbedAssets.cmake), includes come from
+    // embedded as well so nothing is read from disk. names are relative to shaders/
+    Shader(const std::string &vertexName, const std::string &fragmentName, const std::vector<EmbeddedAsset> &embedded,
+           const std::vector<std::string> &defines = {});
+
     void activate();
 
+    // expands #include "file" (relative to the including file) and adds the defines as #defines right after
+    // #version, so a feature switched off is left out of the compiled shader instead of branched around on the GPU.
+    // files, when given, gets path and every file it included
+    static std::string preprocess(const std::string &source, const std::string &path, const std::vector<std::string> &defines,
+                                  std::vector<std::string>* files = NULL);
+
+    // reads path and runs it through preprocess, false if the file itself couldn't be read
+    static bool loadSource(const std::string &path, const std::vector<std::string> &defines, std::string &code,
+                           std::vector<std::string>* files = NULL);
+    static bool loadSource(const std::string &name, const std::vector<EmbeddedAsset> &embedded, const std::vector<std::string> &defines,
+                           std::string &code);
+
+    // names a set of defines, the same set in any order gives the same key
+    static std::string permutationKey(std::vector<std::string> defines);
+
+    // links a program from source, through the binary cache. touches no Shader so it can run on any thread
+    // with a context that shares objects with the one drawing. program is still set when linking failed
+    static bool buildProgram(const std::string &vertexCode, const std::string &fragmentCode, unsigned int &program);
+
+    // swaps in a program linked by buildProgram and deletes the old one, must be called on the drawing thread
+    // between frames. uniform handles and any uniform values set on the old program have to be set up again
+    void replaceProgram(unsigned int program);
+
+    // resolves a handle once, debug builds say if the name isn't active or was declared as a different type
+    template <typename T>
+    UniformHandle<T> uniform(const std::string &name) const{
+        UniformHandle<T> handle;
+        handle.location = findUniform(name, UniformType<T>::VALUE);
+#ifndef NDEBUG
+        if(uniforms.find(name) == uniforms.end()){
+            std::cout << "WARNING: uniform " << name << " is not active in shader program " << ID << std::endl;
+        }
+#endif
+        return handle;
+    }
+
+    // same as the set functions below without the name lookup, the program still has to be active
+    void set(UniformHandle<bool> handle, bool value) const;
+    void set(UniformHandle<int> handle, int value) const;
+    void set(UniformHandle<float> handle, float value) const;
+    void set(UniformHandle<glm::vec2> handle, const glm::vec2 &vec) const;
+    void set(UniformHandle<glm::vec3> handle, const glm::vec3 &vec) const;
+    void set(UniformHandle<glm::vec4> handle, const glm::vec4 &vec) const;
+    void set(UniformHandle<glm::mat2> handle, const glm::mat2 &mat) const;
+    void set(UniformHandle<glm::mat3> handle, const glm::mat3 &mat) const;
+    void set(UniformHandle<glm::mat4> handle, const glm::mat4 &mat) const;
+
     void setBool(const std::string &name, bool value) const; // setters modify GPU uniform and not self so they remain const
     void setInt(const std::string &name, int value) const;   
     void setFloat(const std::string &name, float value) const;
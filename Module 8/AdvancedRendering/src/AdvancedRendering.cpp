@@ -20,6 +20,11 @@
 #include "stb_image.h"
 
 #include "Shader.h"
+#include "FrameUniforms.h"
+#include "ShaderReloader.h"
+#include "ShaderBatch.h"
+#include "GLState.h"
+#include "EmbeddedAssets.h"
 
 
 // function definitions
@@ -36,8 +41,6 @@ const unsigned int VERTEX_CHANNELS = 3;
 float deltaTime = 0.0f;
 float lastframe = 0.0f;
 
-const std::string PROJECT_DIRECTORY = std::filesystem::current_path().string();
-//const std::string PROJECT_DIRECTORY = "C:\\Users\\Shawn\\OneDrive\\Documents\\CSUGlobal\\CSC405\\Module 5\\InteractiveViewer" ;
 
 int main(void)
 {
@@ -69,10 +72,11 @@ int main(void)
         return -1;
     }
 
-    // Creating and building shaders
-    std::string VertexPath = PROJECT_DIRECTORY + "\\shaders\\Vertex.vert";
-    std::string FragmentPath = PROJECT_DIRECTORY + "\\shaders\\Fragment.frag";
-    Shader CubeShader(VertexPath.c_str(),FragmentPath.c_str()); //takes in c-style strings
+    // Creating and building shaders, from the copies compiled into the executable so it runs from any directory
+    // the driver compiles these while the rest gets set up, they're collected right before drawing starts
+    ShaderBatch shaderBatch;
+    shaderBatch.add("Vertex.vert", "Fragment.frag", EMBEDDED_ASSETS);
+    shaderBatch.submit();
 
     // enabling depth test
     glEnable(GL_DEPTH_TEST);
@@ -176,9 +180,10 @@ int main(void)
 
     // load image and create the texture + mipmap
     int textureWidth, textureHeight, nrChannels;
-    std::string texture1Path = PROJECT_DIRECTORY + "\\shaders\\Textures\\StarshipTroopers.jpg";
+    const EmbeddedAsset* texture1File = findEmbeddedAsset(EMBEDDED_ASSETS, "Textures/StarshipTroopers.jpg");
     stbi_set_flip_vertically_on_load(true); // flip the image
-    unsigned char *imageData = stbi_load(texture1Path.c_str(), &textureWidth, &textureHeight, &nrChannels, 0);
+    unsigned char *imageData = stbi_load_from_memory(texture1File->data, static_cast<int>(texture1File->size),
+                                                     &textureWidth, &textureHeight, &nrChannels, 0);
     
 
     // check for loaded
@@ -191,13 +196,37 @@ int main(void)
     // free data we do not need anymore
     stbi_image_free(imageData);
 
+    // view and projection reach every program through one buffer, see FrameUniforms.h
+    FrameUniformBuffer frameUniforms;
+
+    // the window keeps handling events while the driver finishes compiling, then each program gets warmed up
+    // by drawing VAO with the state set above
+    while(!shaderBatch.ready()){
+        glfwWaitEventsTimeout(0.001);
+    }
+    std::vector<Shader> shaders = shaderBatch.collect(VAO);
+    Shader &CubeShader = shaders[0];
+
+    // resolving the uniforms once, the render loop then sets them without any name lookups
+    UniformHandle<int> textureUniform = CubeShader.uniform<int>("texture1");
+    UniformHandle<glm::mat4> modelUniform = CubeShader.uniform<glm::mat4>("model");
+
+    // saving either shader file in the source tree rebuilds the program in the background while this keeps drawing
+    std::string VertexPath = std::string(SHADER_SOURCE_DIRECTORY) + "/Vertex.vert";
+    std::string FragmentPath = std::string(SHADER_SOURCE_DIRECTORY) + "/Fragment.frag";
+    ShaderReloader shaderReloader(window);
+    shaderReloader.watch(CubeShader, VertexPath, FragmentPath);
+    shaderReloader.start();
+
+    // binds and uniform uploads in the render loop go through this, so the ones that wouldn't change anything
+    // are skipped instead of reaching the driver every frame
+    GLState glState;
+
     // passing texture into shaders
-    CubeShader.activate();
-    CubeShader.setInt("texture1", 0);
+    glState.set(CubeShader, textureUniform, 0);
 
-    // passing projection into shaders
+    // projection never changes, it's written into the frame buffer with the view each frame
     glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-    CubeShader.setMat4("projection", projection);
 
     // defining camera
     glm::vec3 cameraPos   = glm::vec3(0.0f, 0.0f,  5.0f);
@@ -215,12 +244,21 @@ int main(void)
         // input
         processInput(window, cameraPos, cameraFront, cameraUp , deltaTime);
 
+        // a rebuilt program only goes in here, between frames, and its uniforms are set up again
+        if(shaderReloader.swapReady()){
+            textureUniform = CubeShader.uniform<int>("texture1");
+            modelUniform = CubeShader.uniform<glm::mat4>("model");
+            // the new program can have the old one's ID, so nothing remembered about it still holds
+            glState.invalidate();
+            glState.set(CubeShader, textureUniform, 0);
+        }
+
         // Black Background
         glClearColor(0.0f, 0.12f, 0.23f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // Activate shader
-        CubeShader.activate();
+        glState.use(CubeShader);
         
         //----------------render the box
 
@@ -235,14 +273,21 @@ int main(void)
 
         view = glm::lookAt( cameraPos, cameraPos + cameraFront, cameraUp);
 
-        CubeShader.setMat4("view", view);
+        // camera for the whole frame goes in one buffer update, only the model matrix is per program
+        FrameUniforms frame = {};
+        frame.view = view;
+        frame.projection = projection;
+        frame.cameraPosition = glm::vec4(cameraPos, 1.0f);
+        frame.time = currentFrame;
+        frameUniforms.update(frame);
 
         // render the box
 
-        CubeShader.setMat4("model", model);
+        glState.set(CubeShader, modelUniform, model);
 
         // render box
-        glBindVertexArray(VAO);
+        glState.bindTexture(0, GL_TEXTURE_2D, texture1);
+        glState.bindVertexArray(VAO);
         glDrawArrays(GL_TRIANGLES, 0, sizeof(vertices) / (sizeof(float) * STRIDE));
 
         /* Swap front and back buffers */
@@ -252,9 +297,15 @@ int main(void)
         glfwPollEvents();
     }
 
+    // how much the state tracking saved over the whole run
+    const GLStateCounters &stateCounters = glState.counters();
+    std::cout << "GL state calls: " << stateCounters.issued << " issued, " << stateCounters.skipped << " skipped" << std::endl;
+
     // Clean up
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
+    frameUniforms.release();
+    shaderReloader.release();
 
     // terminate the window
     glfwTerminate();
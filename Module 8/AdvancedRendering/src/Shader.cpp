@@ -1,4 +1,5 @@
 #include "Shader.h"
+#include "FrameUniforms.h"
 
 #include <iostream>
 #include <fstream>
@@ -8,6 +9,10 @@
 #include <cmath>
 #include <vector>
 #include <string>
+#include <algorithm>
+#include <iomanip>
+#include <iterator>
+#include <cstdint>
 
 
 #include <filesystem>
@@ -15,7 +20,91 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
-Shader::Shader(const char* vertexPath, const char* fragmentPath){
+// program binaries are kept in a directory of this name inside the user's cache directory
+static const char* SHADER_CACHE_DIRECTORY = "opengl_shader_cache";
+// first bytes of every cache file, anything else is treated as damaged
+static const uint32_t BINARY_CACHE_MAGIC = 0x31425053; // "SPB1"
+// deeper than this is taken to be a file including itself
+static const int MAX_INCLUDE_DEPTH = 16;
+
+// from the embedded files when there are some, the disk otherwise
+static bool readShaderFile(const std::string &path, std::string &contents, const std::vector<EmbeddedAsset>* embedded){
+    if(embedded != NULL){
+        const EmbeddedAsset* asset = findEmbeddedAsset(*embedded, path);
+        if(asset == NULL){
+            return false;
+        }
+        contents.assign(reinterpret_cast<const char*>(asset->data), asset->size);
+        return true;
+    }
+    std::ifstream file(path);
+    if(!file){
+        return false;
+    }
+    std::stringstream stream;
+    stream << file.rdbuf();
+    contents = stream.str();
+    return true;
+}
+
+static std::string preprocessLines(const std::string &source, const std::string &path, const std::vector<std::string> &defines,
+                                   std::vector<std::string>* files, const std::vector<EmbeddedAsset>* embedded, int depth){
+    std::string output;
+    std::istringstream lines(source);
+    std::string line;
+    int lineNumber = 0;
+    while(std::getline(lines, line)){
+        lineNumber++;
+        size_t start = line.find_first_not_of(" \t");
+        std::string directive = (start == std::string::npos) ? "" : line.substr(start);
+
+        // defines have to come after #version, which has to be the first thing in the shader
+        if(depth == 0 && directive.compare(0, 8, "#version") == 0){
+            output += line + "\n";
+            for(const std::string &define : defines){
+                output += "#define " + define + "\n";
+            }
+            output += "#line " + std::to_string(lineNumber + 1) + "\n";
+            continue;
+        }
+        if(directive.compare(0, 8, "#include") != 0){
+            output += line + "\n";
+            continue;
+        }
+
+        size_t open = directive.find('"');
+        size_t close = directive.rfind('"');
+        if(open == std::string::npos || close == open){
+            std::cout << "ERROR: " << path << ":" << lineNumber << " #include NEEDS A \"FILE NAME\"" << std::endl;
+            continue;
+        }
+        // relative to the file doing the including, like C
+        std::string directory = std::filesystem::path(path).parent_path().string();
+        std::string name = directive.substr(open + 1, close - open - 1);
+        std::string includePath = directory.empty() ? name : (std::filesystem::path(directory) / name).generic_string();
+        std::string included;
+        if(depth >= MAX_INCLUDE_DEPTH){
+            std::cout << "ERROR: " << includePath << " IS INCLUDED MORE THAN " << MAX_INCLUDE_DEPTH << " DEEP" << std::endl;
+            continue;
+        }
+        if(!readShaderFile(includePath, included, embedded)){
+            std::cout << "ERROR: SHADER INCLUDE " << includePath << " WAS NOT READ" << std::endl;
+            continue;
+        }
+        if(files != NULL){
+            files->push_back(includePath);
+        }
+        // line numbers in compile errors stay right for both files
+        output += "#line 1\n";
+        output += preprocessLines(included, includePath, defines, files, embedded, depth + 1);
+        output += "#line " + std::to_string(lineNumber + 1) + "\n";
+    }
+    return output;
+}
+
+Shader::Shader(const char* vertexPath, const char* fragmentPath) : Shader(vertexPath, fragmentPath, {}){}
+
+Shader::Shader(const char* vertexPath, const char* fragmentPath, const std::vector<std::string> &defines){
     // 1. retrieve the source code from filepaths
     std::string vertexCode;
     std::string fragmentCode;
@@ -47,105 +136,429 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath){
         std::cout << "ERROR: SHADER FILES WERE NOT READ" << std::endl;
     }
 
-    // converting shader code into c-style string
-    const char* vShaderCode = vertexCode.c_str();
-    const char* fShaderCode = fragmentCode.c_str();
+    // 2. expand includes and add this permutation's defines
+    vertexCode = preprocess(vertexCode, vertexPath, defines);
+    fragmentCode = preprocess(fragmentCode, fragmentPath, defines);
 
-    // 2. compile shaders
-    unsigned int vertexShader, fragmentShader;
-    int success;
-    char infoLog[512];
+    // 3. build the program, from the binary cache when an earlier run left one
+    buildProgram(vertexCode, fragmentCode, ID);
+    prepareProgram();
+}
 
-    // Creating and compiling vertex shader
-    vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vShaderCode, NULL);
-    glCompileShader(vertexShader);
+Shader::Shader(unsigned int program){
+    ID = program;
+    prepareProgram();
+}
 
-    // Send Error if failed
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-    if(!success){
-        glGetShaderInfoLog(vertexShader,512, NULL, infoLog);
-        std::cout << "ERROR: VERTEX SHADER FAILED TO COMPILE\n" << infoLog << std::endl;
+Shader::Shader(const std::string &vertexName, const std::string &fragmentName, const std::vector<EmbeddedAsset> &embedded,
+               const std::vector<std::string> &defines){
+    std::string vertexCode;
+    std::string fragmentCode;
+    if(!loadSource(vertexName, embedded, defines, vertexCode) || !loadSource(fragmentName, embedded, defines, fragmentCode)){
+        std::cout << "ERROR: SHADER " << vertexName << " OR " << fragmentName << " WAS NOT EMBEDDED" << std::endl;
     }
+    buildProgram(vertexCode, fragmentCode, ID);
+    prepareProgram();
+}
 
-    // creating and compiling fragment shader
-    fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fShaderCode, NULL);
-    glCompileShader(fragmentShader);
+bool Shader::buildProgram(const std::string &vertexCode, const std::string &fragmentCode, unsigned int &program){
+    // reuse the driver's binary from an earlier run, only compiling when there isn't a usable one
+    std::string cachePath = binaryCachePath(vertexCode, fragmentCode);
+    if(loadProgramBinary(cachePath, program)){
+        return true;
+    }
+    if(!compileProgram(vertexCode, fragmentCode, program)){
+        return false;
+    }
+    saveProgramBinary(cachePath, program);
+    return true;
+}
+
+std::string Shader::preprocess(const std::string &source, const std::string &path, const std::vector<std::string> &defines,
+                               std::vector<std::string>* files){
+    if(files != NULL){
+        files->push_back(path);
+    }
+    return preprocessLines(source, path, defines, files, NULL, 0);
+}
+
+bool Shader::loadSource(const std::string &path, const std::vector<std::string> &defines, std::string &code,
+                        std::vector<std::string>* files){
+    std::string source;
+    if(!readShaderFile(path, source, NULL)){
+        return false;
+    }
+    code = preprocess(source, path, defines, files);
+    return true;
+}
+
+bool Shader::loadSource(const std::string &name, const std::vector<EmbeddedAsset> &embedded, const std::vector<std::string> &defines,
+                        std::string &code){
+    std::string source;
+    if(!readShaderFile(name, source, &embedded)){
+        return false;
+    }
+    code = preprocessLines(source, name, defines, NULL, &embedded, 0);
+    return true;
+}
+
+std::string Shader::permutationKey(std::vector<std::string> defines){
+    std::sort(defines.begin(), defines.end());
+    defines.erase(std::unique(defines.begin(), defines.end()), defines.end());
+    std::string key;
+    for(const std::string &define : defines){
+        key += define + ";";
+    }
+    return key;
+}
+
+void Shader::replaceProgram(unsigned int program){
+    glDeleteProgram(ID);
+    ID = program;
+    prepareProgram();
+}
+
+void Shader::prepareProgram(){
+    reflectUniforms();
+
+    // programs that read the shared per frame block all take it from the same binding point
+    unsigned int frameBlock = glGetUniformBlockIndex(ID, "Frame");
+    if(frameBlock != GL_INVALID_INDEX){
+        glUniformBlockBinding(ID, frameBlock, FRAME_UNIFORM_BINDING);
+    }
+}
+
+bool Shader::compileProgram(const std::string &vertexCode, const std::string &fragmentCode, unsigned int &program){
+    // everything is started before any status is asked for, a status query waits for the driver to finish
+    unsigned int vertexShader = startCompile(GL_VERTEX_SHADER, vertexCode);
+    unsigned int fragmentShader = startCompile(GL_FRAGMENT_SHADER, fragmentCode);
+    program = startLink(vertexShader, fragmentShader);
+
+    // & rather than && so every log gets printed
+    bool success = checkCompile(vertexShader, GL_VERTEX_SHADER) & checkCompile(fragmentShader, GL_FRAGMENT_SHADER)
+                   & checkLink(program);
+
+    // deleting shaders to be responsible, the program keeps what it needs
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    return success;
+}
+
+unsigned int Shader::startCompile(GLenum stage, const std::string &code){
+    // converting shader code into c-style string
+    const char* shaderCode = code.c_str();
+    unsigned int shader = glCreateShader(stage);
+    glShaderSource(shader, 1, &shaderCode, NULL);
+    glCompileShader(shader);
+    return shader;
+}
+
+bool Shader::checkCompile(unsigned int shader, GLenum stage){
+    int success;
+    char infoLog[512];
 
     // Send Error if failed
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
     if(!success){
-        glGetShaderInfoLog(fragmentShader,512, NULL, infoLog);
-        std::cout << "ERROR: FRAGMENT SHADER FAILED TO COMPILE\n" << infoLog << std::endl;
+        glGetShaderInfoLog(shader, 512, NULL, infoLog);
+        std::cout << "ERROR: " << (stage == GL_VERTEX_SHADER ? "VERTEX" : "FRAGMENT") << " SHADER FAILED TO COMPILE\n"
+                  << infoLog << std::endl;
     }
+    return success;
+}
 
+unsigned int Shader::startLink(unsigned int vertexShader, unsigned int fragmentShader){
     // creating the shader program
-    ID = glCreateProgram();
-    glAttachShader(ID, vertexShader);
-    glAttachShader(ID, fragmentShader);
-    glLinkProgram(ID);
+    unsigned int program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    // asking for this before linking lets the driver hand the binary back for the cache
+    if(GLAD_GL_VERSION_4_1){
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glLinkProgram(program);
+    return program;
+}
+
+bool Shader::checkLink(unsigned int program){
+    int success;
+    char infoLog[512];
 
     // looking for linker errors
-    glGetProgramiv(ID,GL_LINK_STATUS,&success);
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
     if(!success){
-        glGetProgramInfoLog(ID, 512, NULL, infoLog);
+        glGetProgramInfoLog(program, 512, NULL, infoLog);
         std::cout << "ERROR: THE LINKING OF THE SHADER PROGAM HAS FAILED\n" << infoLog << std::endl;
     }
+    return success;
+}
 
-    // deleting shaders to be responsible
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+// FNV-1a, only has to tell sources apart, not resist anyone
+static uint64_t hashText(uint64_t hash, const std::string &text){
+    for(unsigned char c : text){
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    // separator so "ab" + "c" and "a" + "bc" don't collide
+    hash ^= 0xFF;
+    hash *= 1099511628211ull;
+    return hash;
+}
+
+// the platform's per user cache directory (the temp directory if there isn't one) so the cache is found again
+// whatever directory the program is started from. worked out once, programs get linked from several threads
+static const std::filesystem::path &shaderCacheDirectory(){
+    static const std::filesystem::path directory = [](){
+        std::filesystem::path base;
+#ifdef _WIN32
+        const char* localAppData = std::getenv("LOCALAPPDATA");
+        if(localAppData && *localAppData){
+            base = localAppData;
+        }
+#else
+        const char* xdgCache = std::getenv("XDG_CACHE_HOME");
+        const char* home = std::getenv("HOME");
+        if(xdgCache && *xdgCache){
+            base = xdgCache;
+        } else if(home && *home){
+#ifdef __APPLE__
+            base = std::filesystem::path(home) / "Library" / "Caches";
+#else
+            base = std::filesystem::path(home) / ".cache";
+#endif
+        }
+#endif
+        if(base.empty()){
+            std::error_code error;
+            base = std::filesystem::temp_directory_path(error);
+        }
+        return base / SHADER_CACHE_DIRECTORY;
+    }();
+    return directory;
+}
+
+static std::string glString(GLenum name){
+    const GLubyte* value = glGetString(name);
+    return value ? reinterpret_cast<const char*>(value) : "";
+}
+
+std::string Shader::binaryCachePath(const std::string &vertexCode, const std::string &fragmentCode){
+    // binaries only load on the driver that made them, so the driver is part of the key
+    uint64_t hash = 14695981039346656037ull;
+    hash = hashText(hash, vertexCode);
+    hash = hashText(hash, fragmentCode);
+    hash = hashText(hash, glString(GL_VENDOR));
+    hash = hashText(hash, glString(GL_RENDERER));
+    hash = hashText(hash, glString(GL_VERSION));
+
+    std::ostringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << hash << ".bin";
+    return (shaderCacheDirectory() / name.str()).string();
+}
+
+bool Shader::loadProgramBinary(const std::string &cachePath, unsigned int &program){
+    int formatCount = 0;
+    if(GLAD_GL_VERSION_4_1){
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    }
+    if(formatCount == 0){
+        return false;
+    }
+
+    std::ifstream file(cachePath, std::ios::binary);
+    if(!file){
+        return false; // first run with these sources
+    }
+    uint32_t magic = 0;
+    GLenum format = 0;
+    file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    file.read(reinterpret_cast<char*>(&format), sizeof(format));
+    std::vector<char> binary;
+    if(file){
+        binary.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    if(magic != BINARY_CACHE_MAGIC || binary.empty()){
+        std::cout << "WARNING: SHADER CACHE " << cachePath << " IS DAMAGED, COMPILING FROM SOURCE" << std::endl;
+        return false;
+    }
+
+    // a driver update can refuse an old binary even with the same version string, that's just a cache miss
+    program = glCreateProgram();
+    glProgramBinary(program, format, binary.data(), static_cast<GLsizei>(binary.size()));
+    int success = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if(!success){
+        glDeleteProgram(program);
+        program = 0;
+        return false;
+    }
+    return true;
+}
+
+void Shader::saveProgramBinary(const std::string &cachePath, unsigned int program){
+    int length = 0;
+    if(GLAD_GL_VERSION_4_1){
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    }
+    if(length <= 0){
+        return; // driver won't give binaries out, every run compiles
+    }
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+
+    // written under a temporary name first so a crash mid write never leaves half a binary behind
+    std::error_code error;
+    std::filesystem::create_directories(shaderCacheDirectory(), error);
+    std::string temporaryPath = cachePath + ".tmp";
+    std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&BINARY_CACHE_MAGIC), sizeof(BINARY_CACHE_MAGIC));
+    file.write(reinterpret_cast<const char*>(&format), sizeof(format));
+    file.write(binary.data(), length);
+    file.close();
+    if(!file){
+        std::cout << "WARNING: COULD NOT WRITE SHADER CACHE " << cachePath << std::endl;
+        std::filesystem::remove(temporaryPath, error);
+        return;
+    }
+    std::filesystem::rename(temporaryPath, cachePath, error);
+}
+
+void Shader::reflectUniforms(){
+    // locations only change when the program is relinked, so every uniform gets asked about once here
+    uniforms.clear();
+    int uniformCount = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &uniformCount);
+    for(int i = 0; i < uniformCount; i++){
+        char name[256];
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = GL_NONE;
+        glGetActiveUniform(ID, i, sizeof(name), &length, &size, &type, name);
+        int location = glGetUniformLocation(ID, name);
+        if(location < 0){
+            continue; // members of uniform blocks don't have locations
+        }
+
+        // arrays come back as "name[0]", they get set by their plain name
+        std::string key(name, length);
+        if(key.size() > 3 && key.compare(key.size() - 3, 3, "[0]") == 0){
+            key.erase(key.size() - 3);
+        }
+        uniforms[key] = { location, type, size };
+    }
+}
+
+// int setters also set bools and texture units, bool setters go through glUniform1i as well
+static bool uniformTypeMatches(GLenum declared, GLenum expected){
+    if(declared == expected){
+        return true;
+    }
+    bool sampler = declared == GL_SAMPLER_1D || declared == GL_SAMPLER_2D || declared == GL_SAMPLER_3D
+                   || declared == GL_SAMPLER_CUBE || declared == GL_SAMPLER_2D_SHADOW || declared == GL_SAMPLER_2D_ARRAY
+                   || declared == GL_INT_SAMPLER_2D || declared == GL_UNSIGNED_INT_SAMPLER_2D;
+    return (expected == GL_INT && (declared == GL_BOOL || sampler)) || (expected == GL_BOOL && declared == GL_INT);
+}
+
+int Shader::findUniform(const std::string &name, GLenum type) const{
+    auto found = uniforms.find(name);
+    if(found == uniforms.end()){
+        return -1;
+    }
+#ifndef NDEBUG
+    if(!uniformTypeMatches(found->second.type, type)){
+        std::cout << "ERROR: UNIFORM " << name << " IS TYPE 0x" << std::hex << found->second.type << " BUT WAS SET AS 0x"
+                  << type << std::dec << std::endl;
+    }
+#endif
+    return found->second.location;
 }
 
 void Shader::activate(){
     glUseProgram(ID);
 }
 
+void Shader::set(UniformHandle<bool> handle, bool value) const{
+    glUniform1i(handle.location, (int)value);
+}
+
+void Shader::set(UniformHandle<int> handle, int value) const{
+    glUniform1i(handle.location, value);
+}
+
+void Shader::set(UniformHandle<float> handle, float value) const{
+    glUniform1f(handle.location, value);
+}
+
+void Shader::set(UniformHandle<glm::vec2> handle, const glm::vec2 &vec) const{
+    glUniform2fv(handle.location, 1, &vec[0]);
+}
+
+void Shader::set(UniformHandle<glm::vec3> handle, const glm::vec3 &vec) const{
+    glUniform3fv(handle.location, 1, &vec[0]);
+}
+
+void Shader::set(UniformHandle<glm::vec4> handle, const glm::vec4 &vec) const{
+    glUniform4fv(handle.location, 1, &vec[0]);
+}
+
+void Shader::set(UniformHandle<glm::mat2> handle, const glm::mat2 &mat) const{
+    glUniformMatrix2fv(handle.location, 1, GL_FALSE, &mat[0][0]);
+}
+
+void Shader::set(UniformHandle<glm::mat3> handle, const glm::mat3 &mat) const{
+    glUniformMatrix3fv(handle.location, 1, GL_FALSE, &mat[0][0]);
+}
+
+void Shader::set(UniformHandle<glm::mat4> handle, const glm::mat4 &mat) const{
+    glUniformMatrix4fv(handle.location, 1, GL_FALSE, &mat[0][0]);
+}
+
+// the name setters look the location up in the reflected table instead of asking GL every call
 void Shader::setBool(const std::string &name, bool value) const{
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); 
+    glUniform1i(findUniform(name, GL_BOOL), (int)value); 
 }
 
 void Shader::setInt(const std::string &name, int value) const{
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
+    glUniform1i(findUniform(name, GL_INT), value); 
 }   
 
 void Shader::setFloat(const std::string &name, float value) const{
-    glUniform1f(glGetUniformLocation(ID, name.c_str()), value); 
+    glUniform1f(findUniform(name, GL_FLOAT), value); 
 }
 
 void Shader::setVec2(const std::string &name, glm::vec2 &vec) const{
-    glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &vec[0]);
+    glUniform2fv(findUniform(name, GL_FLOAT_VEC2), 1, &vec[0]);
 }
 
 void Shader::setVec2(const std::string &name, float x, float y) const{
-    glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+    glUniform2f(findUniform(name, GL_FLOAT_VEC2), x, y);
 }
 
 void Shader::setVec3(const std::string &name, glm::vec3 &vec) const{
-    glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &vec[0]);
+    glUniform3fv(findUniform(name, GL_FLOAT_VEC3), 1, &vec[0]);
 }
 
 void Shader::setVec3(const std::string &name, float x, float y, float z) const{
-    glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+    glUniform3f(findUniform(name, GL_FLOAT_VEC3), x, y, z);
 }
 
 void Shader::setVec4(const std::string &name, glm::vec4 &vec) const{
-    glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &vec[0]);
+    glUniform4fv(findUniform(name, GL_FLOAT_VEC4), 1, &vec[0]);
 }
 
 void Shader::setVec4(const std::string &name, float x, float y, float z, float w) const{
-    glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+    glUniform4f(findUniform(name, GL_FLOAT_VEC4), x, y, z, w);
 }
 
 void Shader::setMat2(const std::string &name, glm::mat2 &mat) const{
-    glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    glUniformMatrix2fv(findUniform(name, GL_FLOAT_MAT2), 1, GL_FALSE, &mat[0][0]);
 }
 
 void Shader::setMat3(const std::string &name, glm::mat3 &mat) const{
-    glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    glUniformMatrix3fv(findUniform(name, GL_FLOAT_MAT3), 1, GL_FALSE, &mat[0][0]);
 }
 
 void Shader::setMat4(const std::string &name, glm::mat4 &mat) const{
-    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    glUniformMatrix4fv(findUniform(name, GL_FLOAT_MAT4), 1, GL_FALSE, &mat[0][0]);
 }
@@ -0,0 +1,25 @@
+#ifndef EMBEDDEDASSET_H
+#define EMBEDDEDASSET_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// a file compiled into the executable by cmake/EmbedAssets.cmake, the generated EmbeddedAssets.h lists them all
+struct EmbeddedAsset {
+    const char* name;          // path relative to shaders/, with / between directories
+    const unsigned char* data; // followed by a 0 that isn't counted in size, so text files work as C strings
+    size_t size;
+};
+
+// NULL if name wasn't embedded
+inline const EmbeddedAsset* findEmbeddedAsset(const std::vector<EmbeddedAsset> &assets, const std::string &name){
+    for(const EmbeddedAsset &asset : assets){
+        if(name == asset.name){
+            return &asset;
+        }
+    }
+    return NULL;
+}
+
+#endif
@@ -0,0 +1,32 @@
+#include "FrameUniforms.h"
+
+// binds UBO to GL_UNIFORM_BUFFER and returns whatever was bound there, so it can be put back afterwards
+// and a GLState tracking that target doesn't go stale
+static GLint bindReplacing(unsigned int UBO){
+    GLint previous = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_BINDING, &previous);
+    glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+    return previous;
+}
+
+FrameUniformBuffer::FrameUniformBuffer(){
+    // storage is made once, every update after that only replaces the contents
+    glGenBuffers(1, &UBO);
+    GLint previous = bindReplacing(UBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), NULL, GL_DYNAMIC_DRAW);
+
+    // programs find it through the binding point, so this never has to be redone. binding the point binds the
+    // general target too, so that goes back afterwards
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORM_BINDING, UBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, previous);
+}
+
+void FrameUniformBuffer::update(const FrameUniforms &frame){
+    GLint previous = bindReplacing(UBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &frame);
+    glBindBuffer(GL_UNIFORM_BUFFER, previous);
+}
+
+void FrameUniformBuffer::release(){
+    glDeleteBuffers(1, &UBO);
+}